@@ -0,0 +1,94 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//Timings of the direct solvers for the stochastic reconfiguration equations
+//as a function of the number of parameters.
+//Usage: sr_solve [nsamples] [npar1 npar2 ...]
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include "netket.hh"
+
+using namespace std;
+using namespace netket;
+
+double Seconds(std::chrono::high_resolution_clock::time_point start){
+  auto end=std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double>(end-start).count();
+}
+
+int main(int argc,char * argv[]){
+  MPI_Init(&argc,&argv);
+
+  int nsamp=1000;
+  vector<int> npars={250,500,1000,2000};
+
+  if(argc>1){
+    nsamp=std::atoi(argv[1]);
+  }
+  if(argc>2){
+    npars.clear();
+    for(int i=2;i<argc;i++){
+      npars.push_back(std::atoi(argv[i]));
+    }
+  }
+
+  const double shift=0.01;
+
+  cout<<"# nsamples = "<<nsamp<<endl;
+  cout<<"# npar  assembly(full)  assembly(lower)  QR  LDLT  LLT  Eigen  (seconds)"<<endl;
+
+  for(auto npar : npars){
+    MatrixXcd Ok=MatrixXcd::Random(nsamp,npar);
+    Ok=Ok.rowwise()-Ok.colwise().mean();
+    VectorXcd b=VectorXcd::Random(npar);
+
+    auto start=std::chrono::high_resolution_clock::now();
+    MatrixXcd Sfull=Ok.adjoint()*Ok;
+    Sfull/=double(nsamp);
+    const double tfull=Seconds(start);
+
+    start=std::chrono::high_resolution_clock::now();
+    MatrixXcd Slower=MatrixXcd::Zero(npar,npar);
+    Slower.selfadjointView<Lower>().rankUpdate(Ok.adjoint());
+    Slower/=double(nsamp);
+    const double tlower=Seconds(start);
+
+    cout<<setw(6)<<npar<<"  "<<tfull<<"  "<<tlower;
+
+    for(string type : {"QR","LDLT","LLT","Eigen"}){
+      SrDenseSolver solver(type);
+      MatrixXcd S=Slower;
+
+      start=std::chrono::high_resolution_clock::now();
+      VectorXcd x=solver.Solve(S,b,shift);
+      const double tsolve=Seconds(start);
+
+      //relative residual, to check the solution
+      //the eigenvalue cutoff discards the null space of S, so the check is done only for the factorizations
+      VectorXcd res=Sfull*x+shift*x-b;
+      if(type!="Eigen" && res.norm()>1.0e-6*b.norm()){
+        cerr<<"# Large residual for "<<type<<": "<<res.norm()/b.norm()<<endl;
+      }
+
+      cout<<"  "<<tsolve;
+    }
+    cout<<endl;
+  }
+
+  MPI_Finalize();
+}
@@ -0,0 +1,161 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef NETKET_BINARYIO_HH
+#define NETKET_BINARYIO_HH
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <complex>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <Eigen/Dense>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Serializes data in a compact binary buffer.
+//Numbers are stored with their native representation,
+//so that they are restored bit-for-bit on the same architecture
+class BinaryWriter{
+
+  std::string buf_;
+
+public:
+
+  template<class T> typename std::enable_if<std::is_arithmetic<T>::value>::type Write(const T & val){
+    WriteRaw(&val,sizeof(T));
+  }
+
+  template<class T> void Write(const std::complex<T> & val){
+    WriteRaw(&val,sizeof(val));
+  }
+
+  template<class T,int R,int C,int O,int MR,int MC> void Write(const Matrix<T,R,C,O,MR,MC> & mat){
+    Write(int64_t(mat.rows()));
+    Write(int64_t(mat.cols()));
+    WriteRaw(mat.data(),sizeof(T)*mat.size());
+  }
+
+  template<class T> void Write(const std::vector<T> & vec){
+    Write(int64_t(vec.size()));
+    for(const auto & val : vec){
+      Write(val);
+    }
+  }
+
+  void Write(const std::string & str){
+    Write(int64_t(str.size()));
+    WriteRaw(str.data(),str.size());
+  }
+
+  //the state of the standard random engines is stored in their textual representation
+  void Write(const std::mt19937 & rgen){
+    std::stringstream ss;
+    ss<<rgen;
+    Write(ss.str());
+  }
+
+  void WriteRaw(const void * data,std::size_t size){
+    buf_.append(static_cast<const char *>(data),size);
+  }
+
+  const std::string & Buffer()const{
+    return buf_;
+  }
+};
+
+//Reads data written by BinaryWriter, in the same order
+class BinaryReader{
+
+  std::string buf_;
+  std::size_t pos_;
+
+public:
+
+  BinaryReader():pos_(0){}
+
+  explicit BinaryReader(const std::string & buf):buf_(buf),pos_(0){}
+
+  template<class T> typename std::enable_if<std::is_arithmetic<T>::value>::type Read(T & val){
+    ReadRaw(&val,sizeof(T));
+  }
+
+  template<class T> void Read(std::complex<T> & val){
+    ReadRaw(&val,sizeof(val));
+  }
+
+  template<class T,int R,int C,int O,int MR,int MC> void Read(Matrix<T,R,C,O,MR,MC> & mat){
+    int64_t rows,cols;
+    Read(rows);
+    Read(cols);
+    CheckSize(rows*cols*sizeof(T));
+    mat.resize(rows,cols);
+    ReadRaw(mat.data(),sizeof(T)*mat.size());
+  }
+
+  template<class T> void Read(std::vector<T> & vec){
+    int64_t size;
+    Read(size);
+    CheckSize(size);
+    vec.resize(size);
+    for(auto & val : vec){
+      Read(val);
+    }
+  }
+
+  void Read(std::string & str){
+    int64_t size;
+    Read(size);
+    CheckSize(size);
+    str.assign(buf_,pos_,size);
+    pos_+=size;
+  }
+
+  void Read(std::mt19937 & rgen){
+    std::string str;
+    Read(str);
+    std::stringstream ss(str);
+    ss>>rgen;
+  }
+
+  void ReadRaw(void * data,std::size_t size){
+    CheckSize(size);
+    std::memcpy(data,buf_.data()+pos_,size);
+    pos_+=size;
+  }
+
+  bool AtEnd()const{
+    return pos_==buf_.size();
+  }
+
+private:
+
+  void CheckSize(int64_t size)const{
+    if(size<0 || pos_+std::size_t(size)>buf_.size()){
+      cerr<<"# Error while reading binary data: the data is truncated or corrupted"<<endl;
+      std::abort();
+    }
+  }
+};
+
+}
+
+#endif
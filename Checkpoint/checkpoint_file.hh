@@ -0,0 +1,227 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef NETKET_CHECKPOINTFILE_HH
+#define NETKET_CHECKPOINTFILE_HH
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <mpi.h>
+
+namespace netket{
+
+using namespace std;
+
+//Binary file storing the state of a calculation.
+//It contains a section shared by all the nodes, written by the root node,
+//followed by a section for each node
+class CheckpointFile{
+
+  //identifies the file format
+  static std::string Magic(){
+    return std::string("NKCKPT");
+  }
+
+  static int32_t Version(){
+    return 1;
+  }
+
+  //Writes data to a temporary file, flushes it to the disk, and moves it over filename.
+  //The directory is then flushed too, so that the new name survives a crash of the system;
+  //this last step is not supported by all file systems, and its errors are ignored
+  static bool WriteAndReplace(const std::string & filename,const std::string & data){
+    const std::string tmpname=filename+string(".tmp");
+
+    int fd=::open(tmpname.c_str(),O_WRONLY|O_CREAT|O_TRUNC,0644);
+    if(fd<0){
+      return false;
+    }
+
+    bool ok=true;
+    std::size_t written=0;
+    while(ok && written<data.size()){
+      ssize_t n=::write(fd,data.data()+written,data.size()-written);
+      if(n<0 && errno==EINTR){
+        continue;
+      }
+      ok=(n>0);
+      if(ok){
+        written+=n;
+      }
+    }
+
+    ok=ok && ::fsync(fd)==0;
+    ok=(::close(fd)==0) && ok;
+
+    if(!ok || std::rename(tmpname.c_str(),filename.c_str())!=0){
+      return false;
+    }
+
+    const std::size_t slash=filename.find_last_of('/');
+    const std::string dirname=(slash==std::string::npos)?string("."):filename.substr(0,std::max(slash,std::size_t(1)));
+    int dirfd=::open(dirname.c_str(),O_RDONLY);
+    if(dirfd>=0){
+      ::fsync(dirfd);
+      ::close(dirfd);
+    }
+    return true;
+  }
+
+public:
+
+  static bool Exists(const std::string & filename){
+    int exists=0;
+    int mynode;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mynode);
+    if(mynode==0){
+      std::ifstream file(filename,std::ios::binary);
+      exists=file.good();
+    }
+    MPI_Bcast(&exists,1,MPI_INT,0,MPI_COMM_WORLD);
+    return exists;
+  }
+
+  //The file is first written to a temporary file, which then replaces the old one,
+  //so that an interrupted write or a crash never corrupts an existing checkpoint
+  static void Save(const std::string & filename,const BinaryWriter & shared,const BinaryWriter & local){
+    int mynode,totalnodes;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mynode);
+    MPI_Comm_size(MPI_COMM_WORLD, &totalnodes);
+
+    const std::string & mine=local.Buffer();
+    int mysize=mine.size();
+
+    vector<int> sizes(totalnodes);
+    MPI_Gather(&mysize,1,MPI_INT,sizes.data(),1,MPI_INT,0,MPI_COMM_WORLD);
+
+    vector<int> offsets(totalnodes,0);
+    for(int r=1;r<totalnodes;r++){
+      offsets[r]=offsets[r-1]+sizes[r-1];
+    }
+
+    std::string all;
+    if(mynode==0){
+      all.resize(offsets[totalnodes-1]+sizes[totalnodes-1]);
+    }
+    MPI_Gatherv(const_cast<char *>(mine.data()),mysize,MPI_CHAR,&all[0],sizes.data(),
+      offsets.data(),MPI_CHAR,0,MPI_COMM_WORLD);
+
+    int ok=1;
+    if(mynode==0){
+      BinaryWriter out;
+      out.Write(Magic());
+      out.Write(Version());
+      out.Write(int32_t(totalnodes));
+      out.Write(shared.Buffer());
+      for(int r=0;r<totalnodes;r++){
+        out.Write(all.substr(offsets[r],sizes[r]));
+      }
+
+      if(!WriteAndReplace(filename,out.Buffer())){
+        cerr<<"# Error while writing the checkpoint file "<<filename<<endl;
+        ok=0;
+      }
+    }
+    MPI_Bcast(&ok,1,MPI_INT,0,MPI_COMM_WORLD);
+    if(!ok){
+      std::abort();
+    }
+  }
+
+  //Reads the shared section and the section of this node.
+  //The file must have been written by the same number of nodes
+  static void Load(const std::string & filename,BinaryReader & shared,BinaryReader & local){
+    int mynode,totalnodes;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mynode);
+    MPI_Comm_size(MPI_COMM_WORLD, &totalnodes);
+
+    int ok=1;
+    std::string sharedbuf;
+    std::string all;
+    vector<int> sizes(totalnodes);
+    vector<int> offsets(totalnodes,0);
+
+    if(mynode==0){
+      std::ifstream file(filename,std::ios::binary);
+      std::string content((std::istreambuf_iterator<char>(file)),std::istreambuf_iterator<char>());
+
+      const std::string magic=Magic();
+      BinaryReader in(content);
+      std::string filemagic;
+      int32_t version=0;
+      int32_t nnodes=0;
+
+      //the header is checked before reading it, since a reading error aborts only this node
+      if(content.size()>=sizeof(int64_t)+magic.size()+2*sizeof(int32_t)
+          && content.compare(sizeof(int64_t),magic.size(),magic)==0){
+        in.Read(filemagic);
+        in.Read(version);
+        in.Read(nnodes);
+      }
+
+      if(filemagic!=magic || version!=Version()){
+        cerr<<"# The file "<<filename<<" is not a valid checkpoint"<<endl;
+        ok=0;
+      }
+      else if(nnodes!=totalnodes){
+        cerr<<"# The checkpoint "<<filename<<" was written by "<<nnodes;
+        cerr<<" processes, but "<<totalnodes<<" are running"<<endl;
+        ok=0;
+      }
+      else{
+        in.Read(sharedbuf);
+        std::string section;
+        for(int r=0;r<totalnodes;r++){
+          in.Read(section);
+          sizes[r]=section.size();
+          offsets[r]=all.size();
+          all+=section;
+        }
+      }
+    }
+
+    MPI_Bcast(&ok,1,MPI_INT,0,MPI_COMM_WORLD);
+    if(!ok){
+      std::abort();
+    }
+
+    int sharedsize=sharedbuf.size();
+    MPI_Bcast(&sharedsize,1,MPI_INT,0,MPI_COMM_WORLD);
+    sharedbuf.resize(sharedsize);
+    MPI_Bcast(&sharedbuf[0],sharedsize,MPI_CHAR,0,MPI_COMM_WORLD);
+
+    int mysize;
+    MPI_Scatter(sizes.data(),1,MPI_INT,&mysize,1,MPI_INT,0,MPI_COMM_WORLD);
+    std::string mine(mysize,'\0');
+    MPI_Scatterv(&all[0],sizes.data(),offsets.data(),MPI_CHAR,&mine[0],mysize,
+      MPI_CHAR,0,MPI_COMM_WORLD);
+
+    shared=BinaryReader(sharedbuf);
+    local=BinaryReader(mine);
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,128 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_EXACTDIAG_CC
+#define NETKET_EXACTDIAG_CC
+
+#include <iostream>
+#include <string>
+#include <mpi.h>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Computes the ground state of the Hamiltonian by exact diagonalization,
+//with the Lanczos method, and the expectation values of the observables on it.
+//The calculation is done by the root node, using several threads
+template<class Ham> class ExactDiag{
+
+  Ham & ham_;
+
+  Observables obs_;
+
+  bool matrixfree_;
+  int nthreads_;
+  int maxiter_;
+  double tol_;
+
+  double energy_;
+  VectorXcd psi_;
+
+  int mynode_;
+
+public:
+
+  ExactDiag(Ham & ham,const json & pars):
+  ham_(ham),obs_(ham.GetHilbert(),pars){
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &mynode_);
+
+    json edpars;
+    if(FieldExists(pars,"ExactDiag")){
+      edpars=pars["ExactDiag"];
+    }
+
+    matrixfree_=FieldOrDefaultVal(edpars,"MatrixFree",false);
+    nthreads_=FieldOrDefaultVal(edpars,"Nthreads",DefaultNthreads());
+    maxiter_=FieldOrDefaultVal(edpars,"MaxIter",1000);
+    tol_=FieldOrDefaultVal(edpars,"Precision",1.0e-12);
+
+    std::string file_base=FieldOrDefaultVal(edpars,"OutputFile",std::string(""));
+
+    if(mynode_==0){
+      Run(file_base);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
+  double Energy()const{
+    return energy_;
+  }
+
+  const VectorXcd & GroundState()const{
+    return psi_;
+  }
+
+private:
+
+  void Run(const std::string & file_base){
+    cout<<"# Exact diagonalization running on "<<nthreads_<<" threads"<<endl;
+
+    const auto & hilbert=ham_.GetHilbert();
+    cout<<"# Hilbert space of "<<hilbert.Dimension()<<" states"<<endl;
+
+    SparseHamiltonian hmat(ham_,hilbert,matrixfree_,nthreads_);
+    if(hmat.IsMatrixFree()){
+      cout<<"# The Hamiltonian is applied without storing it"<<endl;
+    }
+    else{
+      cout<<"# The Hamiltonian has "<<hmat.Nonzeros()<<" non-zero elements"<<endl;
+    }
+
+    Lanczos lanczos(maxiter_,tol_);
+    energy_=lanczos.GroundState(hmat,&psi_);
+
+    json jout;
+    jout["Energy"]=energy_;
+    jout["Dimension"]=hilbert.Dimension();
+    jout["Iterations"]=lanczos.Iterations();
+    jout["Residual"]=lanczos.Residual();
+
+    cout<<"# Ground state energy = "<<std::setprecision(15)<<energy_;
+    cout<<" ("<<lanczos.Iterations()<<" Lanczos iterations)"<<endl;
+    cout<<"# Residual of the ground state = "<<lanczos.Residual()<<endl;
+
+    VectorXcd opsi;
+    for(int k=0;k<obs_.Size();k++){
+      SparseHamiltonian omat(obs_(k),hilbert,true,nthreads_);
+      omat.Apply(psi_,opsi);
+
+      const double val=psi_.dot(opsi).real();
+      jout[obs_(k).Name()]=val;
+      cout<<"# "<<obs_(k).Name()<<" = "<<val<<endl;
+    }
+
+    if(file_base!=""){
+      LogWriter logwriter;
+      logwriter.Open(file_base+std::string(".log"),"Json");
+      logwriter.Write(jout);
+    }
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,165 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_LANCZOS_HH
+#define NETKET_LANCZOS_HH
+
+#include <vector>
+#include <complex>
+#include <random>
+#include <cmath>
+#include <Eigen/Dense>
+#include <Eigen/Eigenvalues>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Lanczos method for the lowest eigenvalue of a Hermitian operator.
+//Only three vectors are kept in memory: the Krylov vectors are generated
+//a second time to construct the eigenvector, if needed.
+//The iterations stop when the norm of the residual op y - E y of the lowest Ritz vector y
+//is below tol times max(1,|E|).
+//The Krylov vectors are not reorthogonalized, since this would need all of them in memory.
+//Once the lowest Ritz value has converged they lose their orthogonality, and spurious copies
+//of it appear in the spectrum of the tridiagonal matrix. The lowest eigenvalue is not affected,
+//but the eigenvector built from the Krylov vectors can be less accurate than the residual estimate:
+//its actual residual is computed explicitly, and returned by Residual()
+class Lanczos{
+
+  int maxiter_;
+  double tol_;
+  int seed_;
+
+  int niter_;
+  double residual_;
+
+public:
+
+  Lanczos(int maxiter=1000,double tol=1.0e-12,int seed=12345):
+    maxiter_(maxiter),tol_(tol),seed_(seed),niter_(0),residual_(0){}
+
+  //Number of iterations done by the last call of GroundState
+  int Iterations()const{
+    return niter_;
+  }
+
+  //Norm of the residual op psi - E psi at the end of the last call of GroundState.
+  //It is computed from psi when the eigenvector is requested,
+  //otherwise it is the estimate given by the Lanczos iterations
+  double Residual()const{
+    return residual_;
+  }
+
+  //Returns the lowest eigenvalue of op, which must have a method Apply(x,y) computing y = op x.
+  //If psi is given, on output it contains the normalized eigenvector
+  template<class Op> double GroundState(const Op & op,VectorXcd * psi=nullptr){
+    vector<double> alpha;
+    vector<double> beta;
+
+    VectorXd eigvec;
+    const double energy=Iterate(op,alpha,beta,eigvec,nullptr);
+
+    if(psi!=nullptr){
+      //same iterations, accumulating the Krylov vectors with the coefficients of the eigenvector
+      Iterate(op,alpha,beta,eigvec,psi);
+      psi->normalize();
+
+      VectorXcd hpsi;
+      op.Apply(*psi,hpsi);
+      residual_=(hpsi-energy*(*psi)).norm();
+    }
+    return energy;
+  }
+
+private:
+
+  template<class Op> double Iterate(const Op & op,vector<double> & alpha,vector<double> & beta,
+      VectorXd & eigvec,VectorXcd * psi){
+
+    const bool firstpass=(psi==nullptr);
+    const long n=op.Size();
+
+    VectorXcd v(n);
+    std::mt19937 rgen(seed_);
+    std::normal_distribution<double> dist;
+    for(long i=0;i<n;i++){
+      v(i)=std::complex<double>(dist(rgen),dist(rgen));
+    }
+    v.normalize();
+
+    VectorXcd vprev=VectorXcd::Zero(n);
+    VectorXcd w;
+
+    if(!firstpass){
+      *psi=eigvec(0)*v;
+    }
+
+    const int niter=firstpass?std::min(long(maxiter_),n):int(alpha.size());
+
+    double energy=0;
+    for(int it=0;it<niter;it++){
+      op.Apply(v,w);
+
+      if(firstpass){
+        alpha.push_back(v.dot(w).real());
+      }
+      w-=alpha[it]*v;
+      if(it>0){
+        w-=beta[it-1]*vprev;
+      }
+
+      if(!firstpass){
+        if(it+1==niter){
+          break;
+        }
+        vprev.swap(v);
+        v=w/beta[it];
+        *psi+=eigvec(it+1)*v;
+        continue;
+      }
+
+      const double b=w.norm();
+
+      //lowest eigenvalue of the tridiagonal matrix
+      const int m=alpha.size();
+      SelfAdjointEigenSolver<MatrixXd> es;
+      VectorXd diag=Map<VectorXd>(alpha.data(),m);
+      VectorXd subdiag=Map<VectorXd>(beta.data(),m-1);
+      es.computeFromTridiagonal(diag,subdiag,ComputeEigenvectors);
+
+      //the residual of the Ritz vector is b times the last component of its coefficients
+      energy=es.eigenvalues()(0);
+      residual_=b*std::abs(es.eigenvectors()(m-1,0));
+      const bool converged=(residual_<=tol_*std::max(1.,std::abs(energy)));
+
+      if(converged || b<1.0e-12 || it+1==niter){
+        eigvec=es.eigenvectors().col(0);
+        niter_=m;
+        break;
+      }
+
+      beta.push_back(b);
+      vprev.swap(v);
+      v=w/b;
+    }
+
+    return energy;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,189 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_SPARSEHAMILTONIAN_HH
+#define NETKET_SPARSEHAMILTONIAN_HH
+
+#include <vector>
+#include <complex>
+#include <functional>
+#include <limits>
+#include <cstdint>
+#include <Eigen/Dense>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Matrix of an operator in the basis of the configurations of its Hilbert space,
+//obtained from the connected elements given by its FindConn.
+//The matrix is either stored in compressed sparse row format,
+//or applied without storing it, calling FindConn at each product.
+//Construction and products are done in parallel over the rows
+class SparseHamiltonian{
+
+  using FindConnType=std::function<void(const VectorXd &,vector<std::complex<double>> &,
+    vector<vector<int>> &,vector<vector<double>> &)>;
+
+  const AbstractHilbert & hilbert_;
+  FindConnType findconn_;
+
+  bool matrixfree_;
+  int nthreads_;
+
+  //compressed sparse row storage
+  vector<int64_t> rowptr_;
+  vector<int32_t> cols_;
+  vector<std::complex<double>> vals_;
+
+public:
+
+  template<class Op> SparseHamiltonian(Op & op,const AbstractHilbert & hilbert,
+      bool matrixfree=false,int nthreads=DefaultNthreads()):
+  hilbert_(hilbert),matrixfree_(matrixfree),nthreads_(nthreads){
+
+    findconn_=[&op](const VectorXd & v,vector<std::complex<double>> & mel,
+        vector<vector<int>> & connectors,vector<vector<double>> & newconfs){
+      op.FindConn(v,mel,connectors,newconfs);
+    };
+
+    if(hilbert_.Dimension()>=std::numeric_limits<int32_t>::max()){
+      matrixfree_=true;
+    }
+
+    if(!matrixfree_){
+      Build();
+    }
+  }
+
+  long Size()const{
+    return hilbert_.Dimension();
+  }
+
+  bool IsMatrixFree()const{
+    return matrixfree_;
+  }
+
+  //Number of stored elements, zero if the matrix is not stored
+  long Nonzeros()const{
+    return vals_.size();
+  }
+
+  //y = H x
+  void Apply(const VectorXcd & x,VectorXcd & y)const{
+    y.resize(Size());
+
+    if(!matrixfree_){
+      ParallelFor(nthreads_,Size(),[&](long begin,long end,int){
+        for(long i=begin;i<end;i++){
+          std::complex<double> yi=0;
+          for(int64_t k=rowptr_[i];k<rowptr_[i+1];k++){
+            yi+=vals_[k]*x(cols_[k]);
+          }
+          y(i)=yi;
+        }
+      });
+      return;
+    }
+
+    ParallelFor(nthreads_,Size(),[&](long begin,long end,int){
+      vector<long> cols;
+      vector<std::complex<double>> vals;
+      for(long i=begin;i<end;i++){
+        Row(i,cols,vals);
+        std::complex<double> yi=0;
+        for(std::size_t k=0;k<cols.size();k++){
+          yi+=vals[k]*x(cols[k]);
+        }
+        y(i)=yi;
+      }
+    });
+  }
+
+private:
+
+  //Non-zero elements of the i-th row
+  void Row(long i,vector<long> & cols,vector<std::complex<double>> & vals)const{
+    vector<std::complex<double>> mel;
+    vector<vector<int>> connectors;
+    vector<vector<double>> newconfs;
+
+    VectorXd v;
+    hilbert_.IndexToState(i,v);
+    findconn_(v,mel,connectors,newconfs);
+
+    cols.clear();
+    vals.clear();
+
+    VectorXd vp;
+    for(std::size_t k=0;k<mel.size();k++){
+      if(mel[k]==0.){
+        continue;
+      }
+      vp=v;
+      for(std::size_t s=0;s<connectors[k].size();s++){
+        vp(connectors[k][s])=newconfs[k][s];
+      }
+
+      const long j=hilbert_.StateToIndex(vp);
+      if(j<0){
+        cerr<<"# The operator connects configurations outside of the Hilbert space"<<endl;
+        std::abort();
+      }
+      cols.push_back(j);
+      vals.push_back(mel[k]);
+    }
+  }
+
+  //Each thread stores the rows of its range, which are then joined in order
+  void Build(){
+    const long n=Size();
+
+    vector<vector<int64_t>> rownnz(nthreads_);
+    vector<vector<int32_t>> cols(nthreads_);
+    vector<vector<std::complex<double>>> vals(nthreads_);
+
+    ParallelFor(nthreads_,n,[&](long begin,long end,int t){
+      vector<long> rcols;
+      vector<std::complex<double>> rvals;
+      for(long i=begin;i<end;i++){
+        Row(i,rcols,rvals);
+        rownnz[t].push_back(rcols.size());
+        cols[t].insert(cols[t].end(),rcols.begin(),rcols.end());
+        vals[t].insert(vals[t].end(),rvals.begin(),rvals.end());
+      }
+    });
+
+    rowptr_.resize(n+1);
+    rowptr_[0]=0;
+    long row=0;
+    for(int t=0;t<nthreads_;t++){
+      for(auto nnz : rownnz[t]){
+        rowptr_[row+1]=rowptr_[row]+nnz;
+        row++;
+      }
+      cols_.insert(cols_.end(),cols[t].begin(),cols[t].end());
+      vals_.insert(vals_.end(),vals[t].begin(),vals[t].end());
+
+      //the memory of each thread is released as soon as it is copied
+      vector<int32_t>().swap(cols[t]);
+      vector<std::complex<double>>().swap(vals[t]);
+    }
+  }
+};
+
+}
+
+#endif
@@ -77,6 +77,69 @@ public:
   virtual void UpdateConf(VectorXd & v,const vector<int>  & tochange,
     const vector<double> & newconf)const=0;
 
+  /**
+  Member function checking if a visible configuration satisfies the constraints
+  on the quantum numbers of the Hilbert space, for example a fixed total magnetization.
+  The default implementation is for Hilbert spaces without constraints.
+  @param v a constant reference to the visible configuration.
+  @return true if the configuration belongs to the constrained Hilbert space.
+  */
+  virtual bool CheckConstraint(const VectorXd & v)const{
+    return true;
+  }
+
+  /**
+  Member function returning the number of configurations of the Hilbert space,
+  taking into account its constraints.
+  @return Dimension of the Hilbert space, or of the constrained sector.
+  */
+  virtual long Dimension()const=0;
+
+  /**
+  Member function mapping a visible configuration to its index
+  in the range 0...Dimension()-1.
+  @param v a constant reference to the visible configuration.
+  @return The index of the configuration, or -1 if the configuration
+  does not belong to the constrained Hilbert space.
+  */
+  virtual long StateToIndex(const VectorXd & v)const=0;
+
+  /**
+  Member function generating the visible configuration with a given index.
+  @param index the index of the configuration, in the range 0...Dimension()-1.
+  @param v a reference to a visible configuration, in output this contains
+  the configuration.
+  */
+  virtual void IndexToState(long index,VectorXd & v)const=0;
+
+  /**
+  Member function mapping several visible configurations to their indices.
+  @param states a constant reference to a matrix whose rows are the visible configurations.
+  @param indices in output contains the indices of the configurations, as given by StateToIndex.
+  */
+  void StatesToIndices(const MatrixXd & states,vector<long> & indices)const{
+    indices.resize(states.rows());
+    VectorXd v;
+    for(int i=0;i<states.rows();i++){
+      v=states.row(i);
+      indices[i]=StateToIndex(v);
+    }
+  }
+
+  /**
+  Member function generating the visible configurations with given indices.
+  @param indices a constant reference to the indices of the configurations.
+  @param states in output is a matrix whose rows are the visible configurations.
+  */
+  void IndicesToStates(const vector<long> & indices,MatrixXd & states)const{
+    states.resize(indices.size(),Size());
+    VectorXd v;
+    for(std::size_t i=0;i<indices.size();i++){
+      IndexToState(indices[i],v);
+      states.row(i)=v;
+    }
+  }
+
 };
 
 }
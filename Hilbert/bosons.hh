@@ -49,6 +49,8 @@ class Boson : public AbstractHilbert{
 
   int nstates_;
 
+  HilbertIndex index_;
+
 public:
 
 
@@ -99,6 +101,7 @@ public:
       local_[i]=i;
     }
 
+    index_.Init(local_,nsites_);
   }
 
   void SetNbosons(int nbosons){
@@ -109,6 +112,8 @@ public:
       cerr<<"Cannot set the desired number of bosons"<<endl;
       std::abort();
     }
+
+    index_.SetConstraint(nbosons_);
   }
 
   bool IsDiscrete()const{
@@ -119,6 +124,18 @@ public:
     return nstates_;
   }
 
+  long Dimension()const{
+    return index_.Dimension();
+  }
+
+  long StateToIndex(const VectorXd & v)const{
+    return index_.StateToIndex(v);
+  }
+
+  void IndexToState(long index,VectorXd & v)const{
+    index_.IndexToState(index,v);
+  }
+
   int Size()const{
     return nsites_;
   }
@@ -155,7 +172,11 @@ public:
     }
   }
 
-  bool CheckConstraint(VectorXd & v)const{
+  bool CheckConstraint(const VectorXd & v)const{
+
+    if(!constraintN_){
+      return true;
+    }
 
     int tot=0;
     for(int i=0;i<v.size();i++){
@@ -39,6 +39,8 @@ class CustomHilbert : public AbstractHilbert{
 
   int size_;
 
+  HilbertIndex index_;
+
 public:
 
   CustomHilbert(const json & pars){
@@ -62,6 +64,8 @@ public:
     }
 
     nstates_=local_.size();
+
+    index_.Init(local_,size_);
   }
 
   bool IsDiscrete()const{
@@ -72,6 +76,18 @@ public:
     return nstates_;
   }
 
+  long Dimension()const{
+    return index_.Dimension();
+  }
+
+  long StateToIndex(const VectorXd & v)const{
+    return index_.StateToIndex(v);
+  }
+
+  void IndexToState(long index,VectorXd & v)const{
+    index_.IndexToState(index,v);
+  }
+
   int Size()const{
     return size_;
   }
@@ -81,6 +81,22 @@ public:
     const vector<double> & newconf)const{
     return h_->UpdateConf(v,tochange,newconf);
   }
+
+  bool CheckConstraint(const VectorXd & v)const{
+    return h_->CheckConstraint(v);
+  }
+
+  long Dimension()const{
+    return h_->Dimension();
+  }
+
+  long StateToIndex(const VectorXd & v)const{
+    return h_->StateToIndex(v);
+  }
+
+  void IndexToState(long index,VectorXd & v)const{
+    return h_->IndexToState(index,v);
+  }
 };
 }
 #endif
@@ -23,15 +23,19 @@ namespace netket{
   class CustomHilbert;
   class Hilbert;
   class LocalOperator;
+  class ZobristHash;
+  class HilbertIndex;
 }
 
 #include "abstract_hilbert.hh"
 #include "next_variation.hh"
+#include "hilbert_index.hh"
 #include "spins.hh"
 #include "bosons.hh"
 #include "qubits.hh"
 #include "custom_hilbert.hh"
 #include "hilbert.cc"
 #include "local_operator.hh"
+#include "zobrist_hash.hh"
 
 #endif
@@ -0,0 +1,257 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_HILBERTINDEX_HH
+#define NETKET_HILBERTINDEX_HH
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <Eigen/Dense>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Maps the configurations of a discrete Hilbert space to consecutive integers, and back.
+//Configurations are ordered lexicographically in the indices of their local states,
+//the first site being the most significant.
+//Optionally, only the configurations whose local indices sum to a given value are counted,
+//which is the case of a fixed total magnetization or number of particles.
+//These are ranked with the combinatorial number system, using a table of the
+//number of configurations of the last sites for each value of their sum,
+//so that both directions take O(N) operations per configuration
+class HilbertIndex{
+
+  vector<double> localstates_;
+  int nstates_;
+  int size_;
+
+  //the local states are equally spaced, and their index is computed directly
+  bool uniform_;
+  double step_;
+
+  bool constrained_;
+
+  //required sum of the local indices
+  int nsum_;
+
+  //powers of the number of local states, without constraints
+  vector<uint64_t> powers_;
+
+  //cumul_[n][m] is the number of configurations of n sites
+  //whose local indices sum to at most m, with constraints
+  vector<vector<uint64_t>> cumul_;
+
+  uint64_t dimension_;
+
+  //the dimension, or some of the counts, do not fit in the integers used for the indices
+  bool toolarge_;
+
+public:
+
+  HilbertIndex():nstates_(0),size_(0),constrained_(false),dimension_(0),toolarge_(false){}
+
+  HilbertIndex(const vector<double> & localstates,int size){
+    Init(localstates,size);
+  }
+
+  void Init(const vector<double> & localstates,int size){
+    localstates_=localstates;
+    nstates_=localstates.size();
+    size_=size;
+    constrained_=false;
+    nsum_=0;
+
+    uniform_=(nstates_>1);
+    step_=(nstates_>1)?(localstates_[1]-localstates_[0]):1;
+    for(int k=1;k<nstates_;k++){
+      if(localstates_[k]!=localstates_[0]+k*step_){
+        uniform_=false;
+      }
+    }
+
+    toolarge_=false;
+    powers_.assign(size_+1,1);
+    for(int n=1;n<=size_;n++){
+      powers_[n]=Multiply(powers_[n-1],nstates_);
+    }
+    dimension_=powers_[size_];
+    cumul_.clear();
+  }
+
+  //Only the configurations whose local indices sum to nsum are counted
+  void SetConstraint(int nsum){
+    constrained_=true;
+    nsum_=nsum;
+
+    toolarge_=false;
+    cumul_.clear();
+
+    if(nsum_<0 || nsum_>size_*(nstates_-1)){
+      dimension_=0;
+      return;
+    }
+
+    cumul_.assign(size_+1,vector<uint64_t>(nsum_+1,1));
+
+    //the number of configurations of n sites with sum m is
+    //the number of configurations of n-1 sites with sum between m-nstates+1 and m
+    for(int n=1;n<=size_;n++){
+      uint64_t tot=0;
+      for(int m=0;m<=nsum_;m++){
+        uint64_t count=Cumul(n-1,m);
+        if(m>=nstates_){
+          count-=Cumul(n-1,m-nstates_);
+        }
+        tot=Add(tot,count);
+        cumul_[n][m]=tot;
+      }
+    }
+    dimension_=Count(size_,nsum_);
+  }
+
+  //Number of configurations
+  long Dimension()const{
+    CheckSize();
+    return long(dimension_);
+  }
+
+  //Returns the index of the configuration, or -1 if it is not in the Hilbert space
+  long StateToIndex(const VectorXd & v)const{
+    CheckSize();
+    assert(v.size()==size_);
+
+    uint64_t index=0;
+
+    if(!constrained_){
+      for(int i=0;i<size_;i++){
+        const int k=LocalIndex(v(i));
+        if(k<0){
+          return -1;
+        }
+        index=index*nstates_+k;
+      }
+      return long(index);
+    }
+
+    //configurations with a smaller local index on site i come first,
+    //and their number is given by the counts of the remaining sites
+    int rem=nsum_;
+    for(int i=0;i<size_;i++){
+      const int k=LocalIndex(v(i));
+      if(k<0 || k>rem){
+        return -1;
+      }
+      if(k>0){
+        index+=Cumul(size_-i-1,rem)-Cumul(size_-i-1,rem-k);
+      }
+      rem-=k;
+    }
+    if(rem!=0){
+      return -1;
+    }
+    return long(index);
+  }
+
+  //Configuration with the given index, which must be smaller than the dimension
+  void IndexToState(long index,VectorXd & v)const{
+    CheckSize();
+    assert(index>=0 && uint64_t(index)<dimension_);
+
+    v.resize(size_);
+    uint64_t rindex=index;
+
+    if(!constrained_){
+      for(int i=size_-1;i>=0;i--){
+        v(i)=localstates_[rindex%nstates_];
+        rindex/=nstates_;
+      }
+      return;
+    }
+
+    int rem=nsum_;
+    for(int i=0;i<size_;i++){
+      int k=0;
+      uint64_t count=Count(size_-i-1,rem);
+      while(rindex>=count){
+        rindex-=count;
+        k++;
+        count=Count(size_-i-1,rem-k);
+      }
+      v(i)=localstates_[k];
+      rem-=k;
+    }
+  }
+
+private:
+
+  void CheckSize()const{
+    if(toolarge_){
+      cerr<<"# The Hilbert space is too large to be indexed"<<endl;
+      std::abort();
+    }
+  }
+
+  //Number of configurations of n sites whose local indices sum to at most m
+  uint64_t Cumul(int n,int m)const{
+    return (m<0)?0:cumul_[n][m];
+  }
+
+  //Number of configurations of n sites whose local indices sum to m
+  uint64_t Count(int n,int m)const{
+    return Cumul(n,m)-Cumul(n,m-1);
+  }
+
+  int LocalIndex(double val)const{
+    if(uniform_){
+      const long k=std::lround((val-localstates_[0])/step_);
+      if(k>=0 && k<nstates_ && localstates_[k]==val){
+        return int(k);
+      }
+      return -1;
+    }
+    for(int k=0;k<nstates_;k++){
+      if(localstates_[k]==val){
+        return k;
+      }
+    }
+    return -1;
+  }
+
+  //Counts are kept below 2^62, so that indices fit in a long
+  uint64_t Add(uint64_t a,uint64_t b){
+    const uint64_t maxcount=uint64_t(1)<<62;
+    if(a+b>maxcount){
+      toolarge_=true;
+      return maxcount;
+    }
+    return a+b;
+  }
+
+  uint64_t Multiply(uint64_t a,uint64_t b){
+    const uint64_t maxcount=uint64_t(1)<<62;
+    if(b!=0 && a>maxcount/b){
+      toolarge_=true;
+      return maxcount;
+    }
+    return a*b;
+  }
+};
+
+}
+
+#endif
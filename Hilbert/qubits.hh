@@ -37,6 +37,8 @@ class Qubit : public AbstractHilbert{
 
   int nqubits_;
 
+  HilbertIndex index_;
+
 public:
 
   Qubit(const json & pars){
@@ -58,6 +60,8 @@ public:
 
     local_[0]=0;
     local_[1]=1;
+
+    index_.Init(local_,nqubits_);
   }
 
 
@@ -69,6 +73,18 @@ public:
     return 2;
   }
 
+  long Dimension()const{
+    return index_.Dimension();
+  }
+
+  long StateToIndex(const VectorXd & v)const{
+    return index_.StateToIndex(v);
+  }
+
+  void IndexToState(long index,VectorXd & v)const{
+    index_.IndexToState(index,v);
+  }
+
   int Size()const{
     return nqubits_;
   }
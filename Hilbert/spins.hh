@@ -46,6 +46,8 @@ class Spin : public AbstractHilbert{
 
   int nspins_;
 
+  HilbertIndex index_;
+
 public:
 
 
@@ -99,21 +101,46 @@ public:
       sp+=2;
     }
 
+    index_.Init(local_,nspins_);
   }
 
   void SetConstraint(double totalS){
     constraintSz_=true;
     totalS_=totalS;
+
+    //the sum of the local indices is S*N+Sz, which must be an integer
+    const double nsum=S_*nspins_+totalS_;
+    index_.SetConstraint((std::floor(nsum)==nsum)?int(nsum):-1);
   }
 
   bool IsDiscrete()const{
     return true;
   }
 
+  //the local quantum numbers are twice the local Sz
+  bool CheckConstraint(const VectorXd & v)const{
+    if(!constraintSz_){
+      return true;
+    }
+    return std::abs(0.5*v.sum()-totalS_)<1.0e-8;
+  }
+
   int LocalSize()const{
     return nstates_;
   }
 
+  long Dimension()const{
+    return index_.Dimension();
+  }
+
+  long StateToIndex(const VectorXd & v)const{
+    return index_.StateToIndex(v);
+  }
+
+  void IndexToState(long index,VectorXd & v)const{
+    index_.IndexToState(index,v);
+  }
+
   int Size()const{
     return nspins_;
   }
@@ -0,0 +1,89 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_ZOBRIST_HASH_HH
+#define NETKET_ZOBRIST_HASH_HH
+
+#include <vector>
+#include <map>
+#include <random>
+#include <cstdint>
+#include <Eigen/Dense>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Zobrist hashing of configurations of a discrete Hilbert space
+//a random 64-bit key is associated to each pair (site, local state),
+//and the hash of a configuration is the xor of the keys of its sites
+class ZobristHash{
+
+  int nv_;
+  int ls_;
+
+  //map from local values to their index
+  std::map<double,int> confindex_;
+
+  //random keys, one for each site and local state
+  std::vector<uint64_t> keys_;
+
+public:
+
+  ZobristHash(const Hilbert & hilbert,uint64_t seed=1234){
+    nv_=hilbert.Size();
+
+    if(hilbert.IsDiscrete()){
+      auto localstates=hilbert.LocalStates();
+      ls_=localstates.size();
+
+      for(int i=0;i<ls_;i++){
+        confindex_[localstates[i]]=i;
+      }
+    }
+    else{
+      ls_=0;
+    }
+
+    //keys are generated with a fixed seed, so that they are the same on all nodes
+    std::mt19937_64 rgen(seed);
+    keys_.resize(nv_*ls_);
+    for(auto & k : keys_){
+      k=rgen();
+    }
+  }
+
+  template<class V> uint64_t operator()(const V & v)const{
+    assert(v.size()==nv_);
+
+    uint64_t h=0;
+    for(int i=0;i<nv_;i++){
+      h^=keys_[ls_*i+confindex_.at(v(i))];
+    }
+    return h;
+  }
+
+  //key of the change of the site i from the local state a to the local state b.
+  //The hash of a configuration after a list of changes is its hash xor the keys of the changes
+  uint64_t ChangeKey(int i,double a,double b)const{
+    assert(i>=0 && i<nv_);
+    return keys_[ls_*i+confindex_.at(a)]^keys_[ls_*i+confindex_.at(b)];
+  }
+
+};
+
+}
+
+#endif
@@ -30,6 +30,8 @@ public:
   virtual void Update(const VectorXcd & grad,VectorXd & pars)=0;
   virtual void Update(const VectorXcd & grad,VectorXcd & pars)=0;
   virtual void Reset()=0;
+  virtual void SaveState(BinaryWriter & out)const=0;
+  virtual void LoadState(BinaryReader & in)=0;
 };
 }
 
@@ -74,6 +74,18 @@ public:
     Eg2_=VectorXd::Zero(npar_);
     Edx2_=VectorXd::Zero(npar_);
   }
+
+  void SaveState(BinaryWriter & out)const{
+    out.Write(npar_);
+    out.Write(Eg2_);
+    out.Write(Edx2_);
+  }
+
+  void LoadState(BinaryReader & in){
+    in.Read(npar_);
+    in.Read(Eg2_);
+    in.Read(Edx2_);
+  }
 };
 
 
@@ -163,6 +163,20 @@ public:
     niter_=0;
   }
 
+  void SaveState(BinaryWriter & out)const{
+    out.Write(npar_);
+    out.Write(mt_);
+    out.Write(ut_);
+    out.Write(niter_);
+  }
+
+  void LoadState(BinaryReader & in){
+    in.Read(npar_);
+    in.Read(mt_);
+    in.Read(ut_);
+    in.Read(niter_);
+  }
+
   void SetResetEvery(double niter_reset){
     niter_reset_=niter_reset;
   }
@@ -0,0 +1,111 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_ASYNCWRITER_HH
+#define NETKET_ASYNCWRITER_HH
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <algorithm>
+
+namespace netket{
+
+using namespace std;
+
+//Executes output tasks, like writing files, in a background thread,
+//so that the calculation does not wait for them.
+//At most maxpending tasks are queued or running at the same time,
+//further requests wait until one of them is completed.
+//Tasks must own copies of the data they write.
+//The thread is started by the first task, so that the processes which do not write,
+//like the MPI nodes other than the root, do not have it
+class AsyncWriter{
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+
+  std::deque<std::function<void()>> tasks_;
+
+  std::size_t maxpending_;
+  bool running_;
+  bool stop_;
+
+public:
+
+  explicit AsyncWriter(std::size_t maxpending=2):
+    maxpending_(std::max(std::size_t(1),maxpending)),running_(false),stop_(false){}
+
+  AsyncWriter(const AsyncWriter &)=delete;
+  AsyncWriter & operator=(const AsyncWriter &)=delete;
+
+  ~AsyncWriter(){
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      stop_=true;
+    }
+    cond_.notify_all();
+    if(thread_.joinable()){
+      thread_.join();
+    }
+  }
+
+  void Push(std::function<void()> task){
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(!thread_.joinable()){
+      thread_=std::thread(&AsyncWriter::Loop,this);
+    }
+    cond_.wait(lock,[this]{return tasks_.size()+(running_?1:0)<maxpending_;});
+    tasks_.push_back(std::move(task));
+    cond_.notify_all();
+  }
+
+  //Waits until all the tasks are completed
+  void Flush(){
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock,[this]{return tasks_.empty() && !running_;});
+  }
+
+private:
+
+  //remaining tasks are completed before stopping
+  void Loop(){
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while(true){
+      cond_.wait(lock,[this]{return stop_ || !tasks_.empty();});
+      if(tasks_.empty()){
+        return;
+      }
+
+      auto task=std::move(tasks_.front());
+      tasks_.pop_front();
+      running_=true;
+
+      lock.unlock();
+      task();
+      lock.lock();
+
+      running_=false;
+      cond_.notify_all();
+    }
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,220 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_ESTIMATOR_HH
+#define NETKET_ESTIMATOR_HH
+
+#include <iostream>
+#include <complex>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <mpi.h>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Measures the energy and the observables of a given wave-function,
+//without optimizing it. The samples are not stored, and the statistics
+//are accumulated as they are generated, so that long runs use a fixed amount of memory.
+//The statistics of all the samples generated so far are written to the log
+//every few samples, and at the end of the run
+template<class Ham,class Psi,class Samp> class Estimator{
+
+  Ham & ham_;
+  Samp & sampler_;
+  Psi & psi_;
+
+  Observables obs_;
+
+  LocalEvaluator<Ham,Psi> evaluator_;
+
+  ObsManager obsmanager_;
+
+  //statistics of the squared modulus of the local energy minus eshift_, used for the variance.
+  //The shift is the first local energy of node 0, so that the squares stay of the order of the variance
+  Binning<double> elocsq_;
+  double eshift_;
+
+  LogWriter logwriter_;
+  string logformat_;
+
+  int sweeps_per_sample_;
+
+  //number of samples discarded at the beginning of the chain, on each node
+  int ndiscard_;
+
+  //number of samples between writes of the statistics
+  double flushevery_;
+
+  int totalnodes_;
+  int mynode_;
+
+public:
+
+  Estimator(Ham & ham,Samp & sampler):
+  ham_(ham),sampler_(sampler),psi_(sampler.Psi()),evaluator_(ham,obs_,psi_){
+
+    Init();
+  }
+
+  //JSON constructor
+  Estimator(Ham & ham,Samp & sampler,const json & pars):
+  ham_(ham),sampler_(sampler),psi_(sampler.Psi()),
+  obs_(ham.GetHilbert(),pars),evaluator_(ham,obs_,psi_){
+
+    if(!FieldExists(pars,"Estimate")){
+      cerr<<"Estimate field is not defined in the input"<<endl;
+      std::abort();
+    }
+
+    Init();
+
+    double nsamples=FieldVal(pars["Estimate"],"Nsamples");
+    std::string file_base=FieldVal(pars["Estimate"],"OutputFile");
+
+    flushevery_=FieldOrDefaultVal(pars["Estimate"],"FlushEvery",nsamples);
+    sweeps_per_sample_=FieldOrDefaultVal(pars["Estimate"],"SweepsPerSample",1);
+    ndiscard_=FieldOrDefaultVal(pars["Estimate"],"DiscardedSamples",0);
+
+    logformat_=FieldOrDefaultVal(pars["Estimate"],"LogFormat",string("Json"));
+    if(!LogWriter::IsValid(logformat_)){
+      if(mynode_==0){
+        cerr<<"# Unknown LogFormat "<<logformat_<<endl;
+      }
+      std::abort();
+    }
+
+    if(mynode_==0){
+      cout<<"# Estimating the energy and the observables on "<<nsamples<<" samples"<<endl;
+      cout<<"# Statistics are written every "<<flushevery_<<" samples"<<endl;
+    }
+
+    SetOutName(file_base);
+
+    Run(nsamples);
+  }
+
+  void Init(){
+    sweeps_per_sample_=1;
+    ndiscard_=0;
+    flushevery_=0;
+    eshift_=0;
+    logformat_="Json";
+
+    obsmanager_.AddObservable("Energy",double());
+    for(int i=0;i<obs_.Size();i++){
+      obsmanager_.AddObservable(obs_(i).Name(),double());
+    }
+
+    MPI_Comm_size(MPI_COMM_WORLD, &totalnodes_);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mynode_);
+
+    if(mynode_==0){
+      cout<<"# Estimator running on "<<totalnodes_<<" processes"<<endl;
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
+  void SetOutName(string filebase){
+    if(mynode_==0){
+      logwriter_.Open(filebase+string(".log"),logformat_);
+    }
+  }
+
+  void Run(double nsamples){
+    //the counts of samples can exceed the range of int in long runs
+    const long long nsampnode=(long long)(std::ceil(nsamples/double(totalnodes_)));
+
+    //all the nodes write the statistics after the same number of samples
+    long long flushnode=nsampnode;
+    if(flushevery_>0){
+      flushnode=std::max(1LL,(long long)(std::ceil(flushevery_/double(totalnodes_))));
+    }
+
+    sampler_.Reset();
+
+    for(int i=0;i<ndiscard_;i++){
+      Sweep();
+    }
+
+    VectorXcd values;
+    int nflush=0;
+
+    for(long long i=0;i<nsampnode;i++){
+      Sweep();
+
+      evaluator_.Evaluate(sampler_.Visible(),values);
+
+      if(i==0){
+        eshift_=values(0).real();
+        SendToAll(eshift_);
+      }
+
+      obsmanager_.Push("Energy",values(0).real());
+      elocsq_<<std::norm(values(0)-eshift_);
+      for(int k=0;k<obs_.Size();k++){
+        obsmanager_.Push(obs_(k).Name(),values(k+1).real());
+      }
+
+      if((i+1)%flushnode==0 || i==nsampnode-1){
+        PrintOutput(nflush,(i+1)*totalnodes_);
+        nflush++;
+      }
+    }
+  }
+
+  void Sweep(){
+    for(int s=0;s<sweeps_per_sample_;s++){
+      sampler_.Sweep();
+    }
+  }
+
+  //Writes the statistics of the samples generated so far
+  void PrintOutput(int iter,long long nsamples){
+    auto jout=json(obsmanager_);
+
+    //the variance is <|E_loc-c|^2>-(<E_loc>-c)^2, with c=eshift_.
+    //Its error is bounded by the errors of the two terms added linearly,
+    //since their correlation is not known
+    double esqmean=elocsq_.Mean();
+    double esqsigma=elocsq_.ErrorOfMean();
+    double ediff=double(jout["Energy"]["Mean"])-eshift_;
+    double esigma=jout["Energy"]["Sigma"];
+    jout["EnergyVariance"]["Mean"]=esqmean-ediff*ediff;
+    jout["EnergyVariance"]["Sigma"]=esqsigma+2.*std::abs(ediff)*esigma;
+
+    auto Acceptance=sampler_.Acceptance();
+    SumOnNodes(Acceptance);
+    Acceptance/=double(totalnodes_);
+
+    jout["Iteration"]=iter;
+    jout["Samples"]=nsamples;
+    jout["Acceptance"]=Acceptance;
+
+    if(mynode_==0){
+      cout<<"# "<<nsamples<<" samples, Energy = "<<jout["Energy"]["Mean"];
+      cout<<" +/- "<<jout["Energy"]["Sigma"]<<endl;
+      logwriter_.Write(jout);
+    }
+  }
+
+};
+
+}
+
+#endif
@@ -35,6 +35,12 @@ public:
     if(pars["Learning"]["Method"]=="Gd" || pars["Learning"]["Method"]=="Sr"){
       s_=new Sr<Ham,Psi,Samp,Opt>(ham,sam,opt,pars);
     }
+    else if(pars["Learning"]["Method"]=="Tdvp"){
+      s_=new Tdvp<Ham,Psi,Samp,Opt>(ham,sam,opt,pars);
+    }
+    else if(pars["Learning"]["Method"]=="Linear"){
+      s_=new LinearMethod<Ham,Psi,Samp,Opt>(ham,sam,opt,pars);
+    }
     else{
       cout<<"Learning method not found"<<endl;
       cout<<pars["Learning"]["Method"]<<endl;
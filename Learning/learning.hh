@@ -23,7 +23,14 @@ namespace netket{
   class Rprop;
   class Stepper;
   template<class Hamiltonian,class Psi,class Sampler,class Optimizer> class Sr;
+  template<class Hamiltonian,class Psi,class Sampler,class Optimizer> class LinearMethod;
+  template<class Hamiltonian,class Psi,class Sampler,class Optimizer> class Tdvp;
   class MatrixReplacement;
+  class SrDenseSolver;
+  class AsyncWriter;
+  class LogWriter;
+  template<class Hamiltonian,class Psi> class LocalEvaluator;
+  template<class Hamiltonian,class Psi,class Sampler> class Estimator;
 
   template<class Hamiltonian,class Psi,class Sampler,class Opt> class AbstractLearning;
   template<class Hamiltonian,class Psi,class Sampler,class Opt> class Learning;
@@ -37,7 +44,14 @@ namespace netket{
 #include "rprop.hh"
 #include "stepper.cc"
 #include "matrix_replacement.hh"
+#include "sr_dense_solver.hh"
+#include "async_writer.hh"
+#include "log_writer.hh"
+#include "local_evaluator.hh"
 #include "sr.hh"
+#include "linear_method.hh"
+#include "tdvp.hh"
 #include "learning.cc"
+#include "estimator.hh"
 
 #endif
@@ -0,0 +1,245 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_LINEAR_METHOD_HH
+#define NETKET_LINEAR_METHOD_HH
+
+#include <iostream>
+#include <string>
+#include <complex>
+#include <Eigen/Dense>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Linear method: the parameters are updated solving the generalized eigenvalue problem
+//for the Hamiltonian in the space of the wave-function and of its derivatives.
+//Sampling, local energies and derivatives are shared with the stochastic reconfiguration
+template<class Ham,class Psi,class Samp,class Opt> class LinearMethod : public Sr<Ham,Psi,Samp,Opt>{
+
+  typedef Sr<Ham,Psi,Samp,Opt> Base;
+  typedef typename Base::VectorT VectorT;
+  typedef typename Base::Evaluator Evaluator;
+
+  using Base::Ok_;
+  using Base::elocs_;
+  using Base::elocmean_;
+  using Base::vsamp_;
+  using Base::mult_;
+  using Base::dedup_;
+  using Base::streaming_;
+  using Base::srnorm_;
+  using Base::npar_;
+  using Base::totalnodes_;
+  using Base::mynode_;
+
+  //derivatives of the local energy with respect to the parameters, for each distinct sample
+  MatrixXcd dEloc_;
+
+  //"Direct" or "Krylov" solution of the eigenvalue problem
+  string linear_solver_;
+
+  //shifts added to the diagonal of the Hamiltonian and of the overlap matrix,
+  //in the space of the derivatives
+  double linear_hshift_;
+  double linear_sshift_;
+
+  int krylov_maxiter_;
+  double krylov_tol_;
+
+public:
+
+  LinearMethod(Ham & ham,Samp & sampler,Opt & opt,const json & pars):
+    Base(ham,sampler,opt,pars,false){
+
+    linear_solver_=FieldOrDefaultVal(pars["Learning"],"LinearSolver",string("Direct"));
+    if(linear_solver_!="Direct" && linear_solver_!="Krylov"){
+      if(mynode_==0){
+        cerr<<"# Unknown LinearSolver "<<linear_solver_<<endl;
+      }
+      std::abort();
+    }
+
+    linear_hshift_=FieldOrDefaultVal(pars["Learning"],"LinearShift",0.1);
+    linear_sshift_=FieldOrDefaultVal(pars["Learning"],"DiagShift",1.0e-3);
+    krylov_maxiter_=FieldOrDefaultVal(pars["Learning"],"KrylovMaxIter",100);
+    krylov_tol_=FieldOrDefaultVal(pars["Learning"],"KrylovTol",1.0e-6);
+
+    if(streaming_){
+      if(mynode_==0){
+        cerr<<"# Streaming accumulation is not available with the linear method"<<endl;
+      }
+      std::abort();
+    }
+
+    this->Start(pars);
+  }
+
+  void PrintMethod(){
+    cout<<"# Using the linear method, with "<<linear_solver_<<" solver"<<endl;
+  }
+
+  void PrepareSamples(int nuniq){
+    dEloc_.resize(nuniq,npar_);
+  }
+
+  //The energy derivatives use the connections found when the local energy was computed
+  void SampleEvaluated(Evaluator & evaluator,int u,const VectorXd & v,const VectorT & derlog){
+    VectorXcd deloc;
+    evaluator.EnergyDerivatives(v,derlog,deloc);
+    dEloc_.row(u)=deloc.transpose();
+  }
+
+  //The change of the parameters is applied directly, without the stepper
+  void ComputeUpdate(VectorT & pars){
+    const VectorXcd deltap=SolveLinear();
+    srnorm_=deltap.norm();
+
+    VectorT delta;
+    this->assign_from_complex(deltap,delta);
+    pars+=delta;
+  }
+
+  //Solves the generalized eigenvalue problem H c = E S c of the linear method,
+  //in the basis of the wave-function and of its centered derivatives.
+  //Here H_ij = <A_i^* B_j> and S_ij = <A_i^* A_j>, where for each sample
+  //A = (1, O-<O>) and B = (E_loc, E_loc (O-<O>) + dE_loc).
+  //The eigenvector with the lowest eigenvalue gives the change of the parameters, c_k/c_0
+  VectorXcd SolveLinear(){
+    const int nuniq=Ok_.rows();
+    const double ntot=double(vsamp_.rows()*totalnodes_);
+
+    //rows of the derivatives and local energies are rescaled
+    //by the square root of the weights in Gradient, and so are the energy derivatives here
+    VectorXd sq=VectorXd::Ones(nuniq);
+    if(dedup_ || (mult_.array()!=1.).any()){
+      sq=mult_.cwiseSqrt();
+    }
+
+    MatrixXcd A(nuniq,npar_+1);
+    MatrixXcd B(nuniq,npar_+1);
+
+    A.col(0)=sq.template cast<complex<double>>();
+    A.rightCols(npar_)=Ok_.template cast<complex<double>>();
+
+    for(int u=0;u<nuniq;u++){
+      //rows with zero weight, such as the padding of the exact sums, do not contribute
+      if(sq(u)==0){
+        B.row(u).setZero();
+        continue;
+      }
+      const complex<double> eloc=elocs_(u)/sq(u)+elocmean_;
+      B(u,0)=sq(u)*eloc;
+      B.row(u).tail(npar_)=eloc*A.row(u).tail(npar_)+sq(u)*dEloc_.row(u);
+    }
+
+    VectorXcd c;
+    if(linear_solver_=="Krylov"){
+      c=SolveLinearKrylov(A,B,ntot);
+    }
+    else{
+      MatrixXcd H=A.adjoint()*B;
+      MatrixXcd S=A.adjoint()*A;
+      SumOnNodes(H);
+      SumOnNodes(S);
+      H/=ntot;
+      S/=ntot;
+
+      H.diagonal().tail(npar_).array()+=linear_hshift_;
+      S.diagonal().tail(npar_).array()+=linear_sshift_;
+
+      c=LowestEigenvector(H,S);
+    }
+
+    return c.tail(npar_)/c(0);
+  }
+
+  //Finds the lowest eigenvector of the generalized problem in a Krylov space,
+  //without constructing H and S. The space is extended with the residual
+  //H c - E S c of the current approximation, starting from the current wave-function
+  VectorXcd SolveLinearKrylov(const MatrixXcd & A,const MatrixXcd & B,double ntot){
+    const int n=npar_+1;
+    const int maxdim=std::min(krylov_maxiter_,n);
+
+    MatrixXcd V(n,maxdim);
+    MatrixXcd HV(n,maxdim);
+    MatrixXcd SV(n,maxdim);
+
+    V.col(0)=VectorXcd::Unit(n,0);
+
+    VectorXcd c=V.col(0);
+    for(int m=0;m<maxdim;m++){
+      //products with the new vector, summed over the nodes
+      VectorXcd hv=A.adjoint()*(B*V.col(m));
+      VectorXcd sv=A.adjoint()*(A*V.col(m));
+      SumOnNodes(hv);
+      SumOnNodes(sv);
+      HV.col(m)=hv/ntot;
+      SV.col(m)=sv/ntot;
+      HV.col(m).tail(npar_)+=linear_hshift_*V.col(m).tail(npar_);
+      SV.col(m).tail(npar_)+=linear_sshift_*V.col(m).tail(npar_);
+
+      const int dim=m+1;
+      const MatrixXcd Hs=V.leftCols(dim).adjoint()*HV.leftCols(dim);
+      const MatrixXcd Ss=V.leftCols(dim).adjoint()*SV.leftCols(dim);
+
+      complex<double> energy;
+      const VectorXcd y=LowestEigenvector(Hs,Ss,&energy);
+
+      c=V.leftCols(dim)*y;
+      VectorXcd r=HV.leftCols(dim)*y-energy*(SV.leftCols(dim)*y);
+
+      if(r.norm()<=krylov_tol_*std::abs(energy) || dim==maxdim){
+        break;
+      }
+
+      //the residual is orthogonalized twice, for numerical stability
+      for(int k=0;k<2;k++){
+        r-=V.leftCols(dim)*(V.leftCols(dim).adjoint()*r);
+      }
+      const double rnorm=r.norm();
+      if(rnorm==0){
+        break;
+      }
+      V.col(dim)=r/rnorm;
+    }
+
+    return c;
+  }
+
+  //Eigenvector of H c = E S c with the lowest real eigenvalue, where S is positive definite
+  VectorXcd LowestEigenvector(const MatrixXcd & H,const MatrixXcd & S,complex<double> * energy=nullptr){
+    const MatrixXcd M=S.ldlt().solve(H);
+
+    ComplexEigenSolver<MatrixXcd> es(M);
+
+    int imin=0;
+    for(int k=1;k<es.eigenvalues().size();k++){
+      if(es.eigenvalues()(k).real()<es.eigenvalues()(imin).real()){
+        imin=k;
+      }
+    }
+
+    if(energy!=nullptr){
+      *energy=es.eigenvalues()(imin);
+    }
+    return es.eigenvectors().col(imin);
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,224 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_LOCALEVALUATOR_HH
+#define NETKET_LOCALEVALUATOR_HH
+
+#include <vector>
+#include <complex>
+#include <unordered_map>
+#include <cstdint>
+#include <algorithm>
+#include <Eigen/Dense>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Computes in a single pass the local values of the Hamiltonian and of the observables,
+//O_loc(v) = sum_v' <v|O|v'> Psi(v')/Psi(v).
+//The configurations v' connected to v by all the operators are collected in a single list,
+//where each distinct configuration appears once, so that the wave-function ratio
+//is computed once for each of them
+template<class Ham,class Psi> class LocalEvaluator{
+
+  Ham & ham_;
+  Observables & obs_;
+  Psi & psi_;
+
+  //the hash of a connected configuration is built from the keys of its changes
+  ZobristHash hasher_;
+  bool discrete_;
+
+  //connections of the last operator
+  vector<std::complex<double>> mel_;
+  vector<vector<int>> connectors_;
+  vector<vector<double>> newconfs_;
+
+  //distinct connected configurations, whether they differ from v,
+  //and their wave-function ratios log(Psi(v')/Psi(v))
+  vector<vector<int>> uconnectors_;
+  vector<vector<double>> unewconfs_;
+  vector<bool> uchanged_;
+  VectorXcd logvaldiffs_;
+
+  //sorted list of the changed sites and of their new values, identifying a connected configuration
+  vector<pair<int,double>> key_;
+
+  //keys of the distinct configurations, stored one after the other;
+  //the key of the j-th configuration starts at ukeystart_[j] and ends at ukeystart_[j+1]
+  vector<pair<int,double>> ukeys_;
+  vector<int> ukeystart_;
+
+  //first distinct configuration with a given hash of its changes;
+  //the other ones with the same hash follow through unext_, and are told apart by their keys
+  std::unordered_map<uint64_t,int> uindex_;
+  vector<int> unext_;
+
+  //for each matrix element, the operator it belongs to, and the index of its connected configuration
+  vector<int> owner_;
+  vector<int> target_;
+  vector<std::complex<double>> allmel_;
+
+  //sum of the Hamiltonian terms leading to each distinct configuration
+  VectorXcd hweights_;
+
+public:
+
+  LocalEvaluator(Ham & ham,Observables & obs,Psi & psi):
+    ham_(ham),obs_(obs),psi_(psi),hasher_(ham.GetHilbert()),
+    discrete_(ham.GetHilbert().IsDiscrete()){}
+
+  //On output, values(0) is the local energy
+  //and values(k+1) is the local value of the k-th observable
+  void Evaluate(const VectorXd & v,VectorXcd & values){
+    Evaluate(v,values,vector<bool>(obs_.Size()+1,true));
+  }
+
+  //Computes only the operators for which active is true,
+  //where active[0] refers to the Hamiltonian and active[k+1] to the k-th observable.
+  //The values of the other operators are set to zero
+  void Evaluate(const VectorXd & v,VectorXcd & values,const vector<bool> & active){
+    assert(active.size()==std::size_t(obs_.Size()+1));
+
+    uconnectors_.clear();
+    unewconfs_.clear();
+    uchanged_.clear();
+    uindex_.clear();
+    unext_.clear();
+    ukeys_.clear();
+    ukeystart_.assign(1,0);
+    owner_.clear();
+    target_.clear();
+    allmel_.clear();
+
+    if(active[0]){
+      ham_.FindConn(v,mel_,connectors_,newconfs_);
+      Collect(v,0);
+    }
+
+    for(int k=0;k<obs_.Size();k++){
+      if(active[k+1]){
+        obs_(k).FindConn(v,mel_,connectors_,newconfs_);
+        Collect(v,k+1);
+      }
+    }
+
+    logvaldiffs_=psi_.LogValDiff(v,uconnectors_,unewconfs_);
+
+    assert(std::size_t(logvaldiffs_.size())==uconnectors_.size());
+
+    values.setZero(obs_.Size()+1);
+
+    for(std::size_t i=0;i<allmel_.size();i++){
+      values(owner_[i])+=allmel_[i]*std::exp(logvaldiffs_(target_[i]));
+    }
+  }
+
+  //Computes the derivatives of the local energy with respect to the parameters,
+  //dE_loc(v) = sum_v' <v|H|v'> Psi(v')/Psi(v) (O(v')-O(v)),
+  //where O are the derivatives of log(Psi), and derlog=O(v).
+  //The connections and the ratios of the last call to Evaluate with the configuration v are used,
+  //and the Hamiltonian must have been active in it.
+  //The derivatives are computed once for each distinct configuration different from v
+  void EnergyDerivatives(const VectorXd & v,const typename Psi::VectorType & derlog,VectorXcd & deloc){
+    hweights_.setZero(uconnectors_.size());
+    for(std::size_t i=0;i<allmel_.size();i++){
+      if(owner_[i]==0){
+        hweights_(target_[i])+=allmel_[i]*std::exp(logvaldiffs_(target_[i]));
+      }
+    }
+
+    deloc.setZero(derlog.size());
+
+    VectorXd vp;
+    for(std::size_t j=0;j<uconnectors_.size();j++){
+      if(!uchanged_[j] || hweights_(j)==0.){
+        continue;
+      }
+      vp=v;
+      for(std::size_t s=0;s<uconnectors_[j].size();s++){
+        vp(uconnectors_[j][s])=unewconfs_[j][s];
+      }
+      deloc+=hweights_(j)*(psi_.DerLog(vp)-derlog).template cast<std::complex<double>>();
+    }
+  }
+
+private:
+
+  void Collect(const VectorXd & v,int owner){
+    assert(connectors_.size()==mel_.size());
+
+    for(std::size_t i=0;i<connectors_.size();i++){
+      //sites whose value does not change are not part of the key.
+      //Without discrete local states all configurations share the same hash
+      key_.clear();
+      uint64_t hash=0;
+      for(std::size_t s=0;s<connectors_[i].size();s++){
+        const int site=connectors_[i][s];
+        if(newconfs_[i][s]!=v(site)){
+          key_.push_back(std::make_pair(site,newconfs_[i][s]));
+          if(discrete_){
+            hash^=hasher_.ChangeKey(site,v(site),newconfs_[i][s]);
+          }
+        }
+      }
+      std::sort(key_.begin(),key_.end());
+
+      auto it=uindex_.find(hash);
+      int index=-1;
+      if(it!=uindex_.end()){
+        for(int j=it->second;j>=0;j=unext_[j]){
+          if(SameKey(j)){
+            index=j;
+            break;
+          }
+        }
+      }
+
+      if(index<0){
+        index=uconnectors_.size();
+        if(it==uindex_.end()){
+          uindex_.emplace(hash,index);
+          unext_.push_back(-1);
+        }
+        else{
+          unext_.push_back(it->second);
+          it->second=index;
+        }
+        ukeys_.insert(ukeys_.end(),key_.begin(),key_.end());
+        ukeystart_.push_back(ukeys_.size());
+        uconnectors_.push_back(connectors_[i]);
+        unewconfs_.push_back(newconfs_[i]);
+        uchanged_.push_back(!key_.empty());
+      }
+
+      owner_.push_back(owner);
+      target_.push_back(index);
+      allmel_.push_back(mel_[i]);
+    }
+  }
+
+  //whether the key of the j-th distinct configuration is equal to key_
+  bool SameKey(int j)const{
+    const std::size_t start=ukeystart_[j];
+    const std::size_t end=ukeystart_[j+1];
+    return end-start==key_.size() && std::equal(key_.begin(),key_.end(),ukeys_.begin()+start);
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,138 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_LOGWRITER_HH
+#define NETKET_LOGWRITER_HH
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+
+namespace netket{
+
+using namespace std;
+
+//Writes the log of an optimization one record at a time,
+//without keeping the previous records in memory.
+//Two formats are available:
+//Json, where the file is a single document {"Output":[record,record,...]},
+//JsonLines, where each line of the file is a record
+class LogWriter{
+
+  std::ofstream file_;
+
+  bool jsonlines_;
+
+  //true if no record has been written in the current file
+  bool empty_;
+
+public:
+
+  LogWriter():jsonlines_(false),empty_(true){}
+
+  static bool IsValid(const string & format){
+    return format=="Json" || format=="JsonLines";
+  }
+
+  //Opens the log, replacing any existing file with the same name.
+  //If keepbefore is positive, the records of the existing file
+  //with iteration smaller than keepbefore are copied in the new one
+  void Open(const string & filename,const string & format,double keepbefore=-1){
+    file_.close();
+    jsonlines_=(format=="JsonLines");
+    empty_=true;
+
+    if(keepbefore<=0){
+      file_.open(filename);
+      return;
+    }
+
+    const string tmpname=filename+string(".tmp");
+    file_.open(tmpname);
+
+    std::ifstream oldfile(filename);
+    if(oldfile.good()){
+      if(jsonlines_){
+        string line;
+        while(std::getline(oldfile,line)){
+          CopyRecord(line,keepbefore);
+        }
+      }
+      else{
+        json oldlog;
+        try{
+          oldfile>>oldlog;
+        }
+        catch(...){
+          oldlog=json();
+        }
+        if(oldlog.count("Output")>0){
+          for(const auto & record : oldlog["Output"]){
+            CopyRecord(record,keepbefore);
+          }
+        }
+      }
+    }
+    oldfile.close();
+    file_.close();
+
+    std::rename(tmpname.c_str(),filename.c_str());
+
+    //the file is reopened without truncating it, to continue writing at its end
+    file_.open(filename,std::ios::in|std::ios::out);
+    file_.seekp(0,std::ios::end);
+  }
+
+  void Write(const json & record){
+    if(jsonlines_){
+      file_<<record<<endl;
+    }
+    else if(empty_){
+      file_<<"{\"Output\":["<<record<<"]}"<<endl;
+    }
+    else{
+      //the closing characters "]}\n" are overwritten, to keep the file a valid document
+      long pos = file_.tellp();
+      file_.seekp(pos - 3);
+      file_.write(",  ",3);
+      file_<<record<< "]}"<<endl;
+    }
+    empty_=false;
+  }
+
+private:
+
+  void CopyRecord(const string & line,double keepbefore){
+    json record;
+    try{
+      record=json::parse(line);
+    }
+    catch(...){
+      //an incomplete last line is skipped
+      return;
+    }
+    CopyRecord(record,keepbefore);
+  }
+
+  void CopyRecord(const json & record,double keepbefore){
+    if(record.count("Iteration")>0 && double(record["Iteration"])<keepbefore){
+      Write(record);
+    }
+  }
+};
+
+}
+
+#endif
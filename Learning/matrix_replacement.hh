@@ -21,6 +21,7 @@
 #include <Eigen/IterativeLinearSolvers>
 #include <unsupported/Eigen/IterativeSolvers>
 #include <complex>
+#include <algorithm>
 
 
 using Eigen::MatrixXcd;
@@ -35,8 +36,10 @@ namespace internal {
 }
 }
 
-// Example of a matrix-free wrapper from a user type to Eigen's compatible type
-// For the sake of simplicity, this example simply wrap a Eigen::SparseMatrix.
+// Matrix-free representation of the S matrix of the stochastic reconfiguration,
+// S = scale * Ok^H Ok + shift, where Ok is distributed over the nodes.
+// The matrix of derivatives is not copied, and can be real or complex,
+// in double or single precision.
 namespace netket{
 class MatrixReplacement : public Eigen::EigenBase<netket::MatrixReplacement> {
 public:
@@ -49,31 +52,248 @@ public:
     MaxColsAtCompileTime = Eigen::Dynamic,
     IsRowMajor = false
   };
-  Index rows() const { return mp_mat_.cols(); }
-  Index cols() const { return mp_mat_.cols(); }
+  Index rows() const { return npar_; }
+  Index cols() const { return npar_; }
   template<typename Rhs>
   Eigen::Product<netket::MatrixReplacement,Rhs,Eigen::AliasFreeProduct> operator*(const Eigen::MatrixBase<Rhs>& x) const {
     return Eigen::Product<netket::MatrixReplacement,Rhs,Eigen::AliasFreeProduct>(*this, x.derived());
   }
   // Custom API:
-  MatrixReplacement() : shift_(0),scale_(1) {}
+  MatrixReplacement() : matc_(nullptr),matd_(nullptr),matcf_(nullptr),matf_(nullptr),
+    npar_(0),shift_(0),scale_(1),single_products_(false) {}
+  // The matrix is only referenced, and must stay alive while the operator is used
   void attachMatrix(const MatrixXcd &mat) {
-    mp_mat_ = mat;
+    detach();
+    matc_=&mat;
+    npar_=mat.cols();
   }
   void attachMatrix(const MatrixXd &mat) {
-    mp_mat_ = mat;
+    detach();
+    matd_=&mat;
+    npar_=mat.cols();
+  }
+  void attachMatrix(const Eigen::MatrixXcf &mat) {
+    detach();
+    matcf_=&mat;
+    npar_=mat.cols();
+  }
+  void attachMatrix(const Eigen::MatrixXf &mat) {
+    detach();
+    matf_=&mat;
+    npar_=mat.cols();
   }
   void setShift(double shift){
     shift_=shift;
   }
-  MatrixXcd my_matrix() const { return mp_mat_; }
   double shift()const {return shift_; }
   void setScale(double scale){scale_=scale;}
   double getScale()const{return scale_;}
+
+  // For matrices stored in single precision, products are done in single precision
+  // if this is set, otherwise they are accumulated in double precision
+  void setSingleProducts(bool single){single_products_=single;}
+
+  // Computes Ok^H Ok x for the rows of Ok stored on this node
+  template<typename Rhs>
+  void applyLocal(const Rhs & x,VectorXcd & res)const{
+    if(matc_!=nullptr){
+      applyLocal(*matc_,x,res);
+    }
+    else if(matd_!=nullptr){
+      applyLocal(*matd_,x,res);
+    }
+    else if(matcf_!=nullptr){
+      applyLocalFloat(*matcf_,x,res);
+    }
+    else{
+      applyLocalFloat(*matf_,x,res);
+    }
+  }
+
+  // Diagonal of the full operator, summed over the nodes
+  VectorXd diagonal()const{
+    VectorXd diag;
+    if(matc_!=nullptr){
+      diag=matc_->cwiseAbs2().colwise().sum().transpose();
+    }
+    else if(matd_!=nullptr){
+      diag=matd_->cwiseAbs2().colwise().sum().transpose();
+    }
+    else if(matcf_!=nullptr){
+      diag=matcf_->cwiseAbs2().cast<double>().colwise().sum().transpose();
+    }
+    else{
+      diag=matf_->cwiseAbs2().cast<double>().colwise().sum().transpose();
+    }
+    netket::SumOnNodes(diag);
+
+    return (diag*scale_).array()+shift_;
+  }
+
 private:
-  MatrixXcd mp_mat_;
+  void detach(){
+    matc_=nullptr;
+    matd_=nullptr;
+    matcf_=nullptr;
+    matf_=nullptr;
+  }
+
+  // number of rows processed together, chosen so that a block fits in cache
+  template<typename Mat>
+  static Index blockSize(const Mat & mat){
+    return std::max(Index(8),Index(262144/(sizeof(typename Mat::Scalar)*std::max(Index(1),mat.cols()))));
+  }
+
+  // Ok x and Ok^H (Ok x) are computed in a single pass over blocks of rows,
+  // so that each block is still in cache when it is used the second time
+  template<typename Mat,typename Rhs>
+  static void applyLocal(const Mat & mat,const Rhs & x,VectorXcd & res){
+    const Index nrows=mat.rows();
+    const Index blocksize=blockSize(mat);
+
+    res.setZero(mat.cols());
+    VectorXcd vtilde;
+
+    for(Index r=0;r<nrows;r+=blocksize){
+      const Index nb=std::min(blocksize,nrows-r);
+      vtilde.noalias()=mat.middleRows(r,nb)*x;
+      res.noalias()+=mat.middleRows(r,nb).adjoint()*vtilde;
+    }
+  }
+
+  // Same as applyLocal, for matrices stored in single precision.
+  // Each block is either used directly in single precision products,
+  // or converted to double precision while it is in cache.
+  // Results of different blocks are always accumulated in double precision
+  template<typename Mat,typename Rhs>
+  void applyLocalFloat(const Mat & mat,const Rhs & x,VectorXcd & res)const{
+    const Index nrows=mat.rows();
+    const Index blocksize=blockSize(mat);
+
+    res.setZero(mat.cols());
+
+    if(single_products_){
+      applySingleProducts(mat,x,res,blocksize);
+    }
+    else{
+      MatrixXcd block;
+      VectorXcd vtilde;
+
+      for(Index r=0;r<nrows;r+=blocksize){
+        const Index nb=std::min(blocksize,nrows-r);
+        block=mat.middleRows(r,nb).template cast<Scalar>();
+        vtilde.noalias()=block*x;
+        res.noalias()+=block.adjoint()*vtilde;
+      }
+    }
+  }
+
+  // Single precision products are done with real matrices only,
+  // since the complex<float> kernels of Eigen are not faster and trigger
+  // spurious uninitialized warnings in gcc.
+  // For a real matrix, the real and imaginary parts of x are multiplied separately
+  template<typename Rhs>
+  static void applySingleProducts(const Eigen::MatrixXf & mat,const Rhs & x,VectorXcd & res,Index blocksize){
+    const Index nrows=mat.rows();
+    const Eigen::VectorXf xr=x.real().template cast<float>();
+    const Eigen::VectorXf xi=x.imag().template cast<float>();
+    Eigen::VectorXf vr,vi;
+
+    for(Index r=0;r<nrows;r+=blocksize){
+      const Index nb=std::min(blocksize,nrows-r);
+      vr.noalias()=mat.middleRows(r,nb)*xr;
+      vi.noalias()=mat.middleRows(r,nb)*xi;
+      res.real()+=(mat.middleRows(r,nb).transpose()*vr).template cast<double>();
+      res.imag()+=(mat.middleRows(r,nb).transpose()*vi).template cast<double>();
+    }
+  }
+
+  // A complex matrix is seen as a real one with twice the rows,
+  // the even rows holding the real parts and the odd rows the imaginary parts
+  template<typename Rhs>
+  static void applySingleProducts(const Eigen::MatrixXcf & mat,const Rhs & x,VectorXcd & res,Index blocksize){
+    typedef Eigen::Map<Eigen::VectorXf,0,Eigen::InnerStride<2>> Strided;
+
+    const Index nrows=mat.rows();
+    const Eigen::Map<const Eigen::MatrixXf> matr(reinterpret_cast<const float*>(mat.data()),2*nrows,mat.cols());
+    const Eigen::VectorXf xr=x.real().template cast<float>();
+    const Eigen::VectorXf xi=x.imag().template cast<float>();
+    Eigen::VectorXf ur,ui,v,w;
+
+    for(Index r=0;r<nrows;r+=blocksize){
+      const Index nb=std::min(blocksize,nrows-r);
+      const auto block=matr.middleRows(2*r,2*nb);
+
+      ur.noalias()=block*xr;
+      ui.noalias()=block*xi;
+
+      //v holds the real and imaginary parts of Ok x, w those of -i Ok x
+      v.resize(2*nb);
+      w.resize(2*nb);
+      Strided(v.data(),nb)=Strided(ur.data(),nb)-Strided(ui.data()+1,nb);
+      Strided(v.data()+1,nb)=Strided(ur.data()+1,nb)+Strided(ui.data(),nb);
+      Strided(w.data(),nb)=Strided(v.data()+1,nb);
+      Strided(w.data()+1,nb)=-Strided(v.data(),nb);
+
+      res.real()+=(block.transpose()*v).template cast<double>();
+      res.imag()+=(block.transpose()*w).template cast<double>();
+    }
+  }
+
+  const MatrixXcd * matc_;
+  const MatrixXd * matd_;
+  const Eigen::MatrixXcf * matcf_;
+  const Eigen::MatrixXf * matf_;
+  Index npar_;
   double shift_;
   double scale_;
+  bool single_products_;
+};
+
+// Jacobi preconditioner for the S matrix, using its diagonal
+class JacobiPreconditioner{
+public:
+  typedef std::complex<double> Scalar;
+
+  JacobiPreconditioner() {}
+
+  template<typename MatType>
+  explicit JacobiPreconditioner(const MatType& mat){
+    compute(mat);
+  }
+
+  Index rows() const { return invdiag_.size(); }
+  Index cols() const { return invdiag_.size(); }
+
+  template<typename MatType>
+  JacobiPreconditioner& analyzePattern(const MatType& ){
+    return *this;
+  }
+
+  template<typename MatType>
+  JacobiPreconditioner& factorize(const MatType& mat){
+    invdiag_=mat.diagonal();
+    for(Index i=0;i<invdiag_.size();i++){
+      invdiag_(i)=(invdiag_(i)>0)?1./invdiag_(i):1.;
+    }
+    return *this;
+  }
+
+  template<typename MatType>
+  JacobiPreconditioner& compute(const MatType& mat){
+    return factorize(mat);
+  }
+
+  template<typename Rhs>
+  VectorXcd solve(const Eigen::MatrixBase<Rhs>& b) const{
+    assert(invdiag_.size()==b.rows());
+    return invdiag_.cast<Scalar>().cwiseProduct(b);
+  }
+
+  Eigen::ComputationInfo info() { return Eigen::Success; }
+
+private:
+  VectorXd invdiag_;
 };
 }
 
@@ -90,8 +310,8 @@ namespace internal {
     {
       // This method should implement "dst += alpha * lhs * rhs" inplace,
 
-      auto vtilde=lhs.my_matrix()*rhs;
-      VectorXcd res=lhs.my_matrix().adjoint()*vtilde;
+      VectorXcd res;
+      lhs.applyLocal(rhs,res);
       netket::SumOnNodes(res);
 
       double nor= lhs.getScale();
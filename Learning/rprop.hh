@@ -88,6 +88,18 @@ public:
   void Reset(){
 
   }
+
+  void SaveState(BinaryWriter & out)const{
+    out.Write(npar_);
+    out.Write(oldgrad_);
+    out.Write(delta_);
+  }
+
+  void LoadState(BinaryReader & in){
+    in.Read(npar_);
+    in.Read(oldgrad_);
+    in.Read(delta_);
+  }
 };
 
 
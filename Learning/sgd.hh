@@ -96,6 +96,15 @@ public:
 
   void Reset(){
   }
+
+  //the learning rate changes during the optimization when a decay factor is used
+  void SaveState(BinaryWriter & out)const{
+    out.Write(eta_);
+  }
+
+  void LoadState(BinaryReader & in){
+    in.Read(eta_);
+  }
 };
 
 
@@ -24,6 +24,12 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <type_traits>
+#include <memory>
+#include <thread>
+#include <limits>
+#include <cmath>
 #include <mpi.h>
 
 namespace netket{
@@ -35,9 +41,18 @@ using namespace Eigen;
 //both direct and sparse version available
 template<class Ham,class Psi,class Samp,class Opt> class Sr : public AbstractLearning<Ham, Psi, Samp, Opt>{
 
+protected:
+
   typedef Matrix<typename Psi::StateType, Dynamic, 1 > VectorT;
   typedef Matrix<typename Psi::StateType, Dynamic, Dynamic > MatrixT;
 
+  typedef typename std::conditional<NumTraits<typename Psi::StateType>::IsComplex,
+    std::complex<float>,float>::type StateTypeF;
+  typedef Matrix<StateTypeF, Dynamic, Dynamic > MatrixTF;
+
+  //the evaluators of the main machine and of its copies have the same type
+  typedef LocalEvaluator<Ham,AbstractMachine<typename Psi::StateType>> Evaluator;
+
   Ham & ham_;
   Samp & sampler_;
   Psi & psi_;
@@ -50,8 +65,73 @@ template<class Ham,class Psi,class Samp,class Opt> class Sr : public AbstractLea
   MatrixT Ok_;
   VectorT Okmean_;
 
+  //centered derivatives stored in single precision, used by the iterative solver
+  MatrixTF Okf_;
+
   MatrixXd vsamp_;
 
+  //logarithm of the wave-function for each sample
+  VectorT logvsamp_;
+
+  //importance-sampling weights of the samples, normalized to have unit mean
+  VectorXd weights_;
+
+  //maximum number of iterations for which samples are reused,
+  //and minimum fraction of effective samples below which new samples are generated
+  int reuse_max_;
+  double reuse_threshold_;
+  int nreused_;
+  double ess_;
+
+  //if true, the samples of the next iteration are generated while the parameters are updated,
+  //using the parameters of the current iteration
+  bool pipelined_;
+
+  //true if the current samples were generated with the parameters of the previous iteration
+  bool prefetched_;
+
+  //number of samples to generate during the next update, zero if none
+  double nextsweeps_;
+  MatrixXd vsampnext_;
+  VectorT logvsampnext_;
+
+  //number of samples of the next iteration, changed between minsamples_ and maxsamples_
+  //to keep the signal-to-noise ratio of the gradient close to target_snr_, if adaptive_ is true
+  bool adaptive_;
+  double nsamples_;
+  double minsamples_;
+  double maxsamples_;
+  double target_snr_;
+  double adapt_factor_;
+
+  //statistical noise of the gradient, and its signal-to-noise ratio
+  double gradnoise_;
+  double gradsnr_;
+
+  //norm of the solution of the SR equations at the last two iterations
+  double srnorm_;
+  double srnormprev_;
+
+  //the optimization stops when the energy and its variance are constant within
+  //stop_tolerance_ error bars over the last stop_window_ iterations, if stop_window_>0
+  int stop_window_;
+  double stop_tolerance_;
+  vector<double> ehist_;
+  vector<double> esigma_;
+  vector<double> varhist_;
+  vector<double> varsigma_;
+
+  //if true, identical samples are evaluated only once
+  bool dedup_;
+  ZobristHash hasher_;
+
+  //rows of vsamp_ containing distinct configurations, and their total weights
+  vector<int> urows_;
+  VectorXd mult_;
+
+  //index of the distinct configuration corresponding to each sample
+  vector<int> uniqueidx_;
+
   VectorXcd grad_;
   VectorXcd gradprev_;
 
@@ -65,69 +145,404 @@ template<class Ham,class Psi,class Samp,class Opt> class Sr : public AbstractLea
   bool sr_rescale_shift_;
   bool use_iterative_;
 
+  //method used to solve the SR equations:
+  //ParameterSpace, SampleSpace, Iterative, BlockDiagonal or Auto
+  string solver_type_;
+
+  //blocks of parameters for the block-diagonal approximation of the S matrix
+  vector<vector<int>> blocks_;
+
+  //factorization used for the explicit S matrix
+  SrDenseSolver dense_solver_;
+
+  //if positive, the diagonal shift is increased until the norm of the update is below this value,
+  //re-using the eigen-decomposition of S, at most shift_retries_ times
+  double max_update_norm_;
+  int shift_retries_;
+
+  //options of the iterative solver
+  bool use_jacobi_;
+  bool warm_start_;
+
+  //if true, the derivatives are stored in single precision for the iterative solver,
+  //and the solution is refined with residuals computed with double precision products
+  bool single_precision_;
+
+  //if true, the explicit S matrix is reduced and solved only on the root node
+  bool solve_on_root_;
+
+  //if true, the S matrix and the gradient are accumulated over chunks of samples,
+  //without storing the derivatives of all the samples
+  bool streaming_;
+  int chunk_size_;
+
+  //lower triangle of the S matrix accumulated in streaming mode, not yet summed over the nodes
+  MatrixXcd Sacc_;
+
+  //if true, expectation values are sums over all the configurations of the Hilbert space,
+  //weighted by |Psi|^2, instead of averages over Monte Carlo samples.
+  //The configurations are split among the nodes and stored in vsamp_,
+  //the first nexact_ rows being the ones assigned to this node
+  bool exact_;
+  int nexact_;
+
+  //threads evaluating the configurations of this node in exact mode,
+  //each with its own copy of the machine
+  int nthreads_;
+
+  //exact averages of the energy, of its variance and of the observables
+  VectorXd exactvals_;
+
+  vector<std::unique_ptr<AbstractMachine<typename Psi::StateType>>> clones_;
+  vector<std::unique_ptr<Evaluator>> evaluators_;
+
+  //sums of the local energies, of the shifted derivatives,
+  //and of their products with the shifted local energies
+  VectorXcd streamsums_;
+
   int totalnodes_;
   int mynode_;
 
-  ofstream filelog_;
+  //the log is written only by the root node, one iteration at a time
+  LogWriter logwriter_;
+  string logformat_;
+
+  //vector quantities written in the log at each iteration
+  vector<string> logvectors_;
+
+  //when resuming, iterations of the old log before this one are kept
+  double logkeep_;
+
   string filewfname_;
   double freqbackup_;
 
+  //the log and the wave-function are written in the background by the root node
+  AsyncWriter writer_;
+
+  //file storing the full state of the optimization, and how often it is written
+  string filecheckpoint_;
+  double freqcheckpoint_;
+
+  //iteration from which the next call to Run starts, when resuming from a checkpoint
+  double iterstart_;
+
   Opt & opt_;
 
   Observables obs_;
   ObsManager obsmanager_;
-  json outputjson_;
+
+  //computes the local energy and the local observables together
+  Evaluator evaluator_;
+
+  //operators evaluated on the samples of the current iteration,
+  //the first one is the Hamiltonian and the others are the observables
+  vector<bool> measure_;
+
+  //observables evaluated on dedicated samples in the current iteration
+  vector<bool> dedicated_;
+
+  //number of samples of the measurement done after the optimization
+  double final_nsamples_;
 
   bool dosr_;
 
+  //number of sweeps between two recorded samples
+  int sweeps_per_sample_;
+
+  //parameters controlling the automatic tuning of sweeps_per_sample_
+  bool autosweeps_;
+  double tune_every_;
+  int tune_nsweeps_;
+  int max_sweeps_per_sample_;
+  bool tune_logpsi_;
+
 public:
 
   Sr(Ham & ham,Samp & sampler,Opt & opt):
-  ham_(ham),sampler_(sampler),psi_(sampler.Psi()),opt_(opt){
+  ham_(ham),sampler_(sampler),psi_(sampler.Psi()),hasher_(psi_.GetHilbert()),opt_(opt),
+  evaluator_(ham,obs_,psi_){
 
     Init();
   }
 
-  //JSON constructor
-  Sr(Ham & ham, Samp & sampler, Opt & opt,const json & pars):
-  ham_(ham),sampler_(sampler),psi_(sampler.Psi()),opt_(opt),
-  obs_(ham.GetHilbert(),pars){
+  //JSON constructor.
+  //If start is true, the optimization runs at the end of the constructor.
+  //Methods derived from Sr pass false, and call Start once they are configured
+  Sr(Ham & ham, Samp & sampler, Opt & opt,const json & pars,bool start=true):
+  ham_(ham),sampler_(sampler),psi_(sampler.Psi()),hasher_(psi_.GetHilbert()),opt_(opt),
+  obs_(ham.GetHilbert(),pars),evaluator_(ham,obs_,psi_){
 
     Init();
 
-    int nsamples=FieldVal(pars["Learning"],"Nsamples");
-    int niter_opt=FieldVal(pars["Learning"],"NiterOpt");
+    exact_=FieldOrDefaultVal(pars["Learning"],"Exact",false);
+    nthreads_=std::max(1,int(FieldOrDefaultVal(pars["Learning"],"Nthreads",DefaultNthreads())));
 
-    std::string file_base=FieldVal(pars["Learning"],"OutputFile");
-    double freqbackup=FieldOrDefaultVal(pars["Learning"],"SaveEvery",100.);
-    SetOutName(file_base,freqbackup);
+    const int nsamples=NsamplesOption(pars);
 
-    if(pars["Learning"]["Method"]=="Gd"){
+    final_nsamples_=FieldOrDefaultVal(pars["Learning"],"MeasureNsamples",0.);
+
+    logformat_=FieldOrDefaultVal(pars["Learning"],"LogFormat",string("Json"));
+    if(!LogWriter::IsValid(logformat_)){
+      if(mynode_==0){
+        cerr<<"# Unknown LogFormat "<<logformat_<<endl;
+      }
+      std::abort();
+    }
+
+    if(FieldExists(pars["Learning"],"LogVectors")){
+      logvectors_=pars["Learning"]["LogVectors"].get<vector<string>>();
+    }
+    for(const auto & name : logvectors_){
+      if(name!="Acceptance" && name!="Gradient" && name!="Parameters"){
+        if(mynode_==0){
+          cerr<<"# Unknown vector "<<name<<" in LogVectors"<<endl;
+        }
+        std::abort();
+      }
+    }
+
+    //the options of the SR equations are read only by the methods solving them
+    if(pars["Learning"]["Method"]!="Sr" && pars["Learning"]["Method"]!="Tdvp"){
       dosr_=false;
     }
     else{
       double diagshift=FieldOrDefaultVal(pars["Learning"],"DiagShift",0.01);
       bool rescale_shift=FieldOrDefaultVal(pars["Learning"],"RescaleShift",false);
       bool use_iterative=FieldOrDefaultVal(pars["Learning"],"UseIterative",false);
+      string solver=FieldOrDefaultVal(pars["Learning"],"SolverType",string("ParameterSpace"));
+
+      if(solver!="ParameterSpace" && solver!="SampleSpace" && solver!="Iterative"
+          && solver!="BlockDiagonal" && solver!="Auto"){
+        if(mynode_==0){
+          cerr<<"# Unknown SolverType "<<solver<<endl;
+        }
+        std::abort();
+      }
+
+      string dense=FieldOrDefaultVal(pars["Learning"],"DenseSolver",string("QR"));
+      double cutoff=FieldOrDefaultVal(pars["Learning"],"EigenCutoff",1.0e-10);
+
+      if(!SrDenseSolver::IsValid(dense)){
+        if(mynode_==0){
+          cerr<<"# Unknown DenseSolver "<<dense<<endl;
+        }
+        std::abort();
+      }
+      dense_solver_=SrDenseSolver(dense,cutoff);
 
-      setSrParameters(diagshift,rescale_shift,use_iterative);
+      max_update_norm_=FieldOrDefaultVal(pars["Learning"],"MaxUpdateNorm",0.);
+      shift_retries_=FieldOrDefaultVal(pars["Learning"],"ShiftRetries",5);
+      if(max_update_norm_>0 && dense!="Eigen"){
+        if(mynode_==0){
+          cerr<<"# MaxUpdateNorm requires the Eigen dense solver"<<endl;
+        }
+        std::abort();
+      }
+
+      solve_on_root_=FieldOrDefaultVal(pars["Learning"],"SolveOnRoot",false);
+
+      string precond=FieldOrDefaultVal(pars["Learning"],"Preconditioner",string("Jacobi"));
+      if(precond!="Jacobi" && precond!="None"){
+        if(mynode_==0){
+          cerr<<"# Unknown Preconditioner "<<precond<<endl;
+        }
+        std::abort();
+      }
+      use_jacobi_=(precond=="Jacobi");
+      warm_start_=FieldOrDefaultVal(pars["Learning"],"WarmStart",true);
+      single_precision_=FieldOrDefaultVal(pars["Learning"],"SinglePrecision",false);
+
+      setSrParameters(diagshift,rescale_shift,use_iterative,solver);
+
+      if(single_precision_ && !use_iterative_){
+        if(mynode_==0){
+          cerr<<"# Single precision storage is available only with the Iterative solver"<<endl;
+        }
+        std::abort();
+      }
+
+      if(solver_type_=="BlockDiagonal"){
+        int blocksize=FieldOrDefaultVal(pars["Learning"],"BlockSize",0);
+        SetParameterBlocks(blocksize);
+      }
     }
 
-    if(mynode_==0){
-      if(dosr_){
-        cout<<"# Using the Stochastic reconfiguration method"<<endl;
-        if(use_iterative_){
-          cout<<"# With iterative solver"<<endl;
+    streaming_=FieldOrDefaultVal(pars["Learning"],"Streaming",false);
+    chunk_size_=FieldOrDefaultVal(pars["Learning"],"ChunkSize",256);
+
+    if(streaming_ && dosr_ && solver_type_!="ParameterSpace" && solver_type_!="Auto"){
+      if(mynode_==0){
+        cerr<<"# Streaming accumulation is available only with the ParameterSpace solver"<<endl;
+      }
+      std::abort();
+    }
+
+    sweeps_per_sample_=FieldOrDefaultVal(pars["Learning"],"SweepsPerSample",1);
+    autosweeps_=FieldOrDefaultVal(pars["Learning"],"AutoSweeps",false);
+    tune_every_=FieldOrDefaultVal(pars["Learning"],"TuneEvery",10.);
+    tune_nsweeps_=FieldOrDefaultVal(pars["Learning"],"TuneSweeps",512);
+    max_sweeps_per_sample_=FieldOrDefaultVal(pars["Learning"],"MaxSweepsPerSample",64);
+    tune_logpsi_=FieldOrDefaultVal(pars["Learning"],"TuneLogPsi",false);
+
+    dedup_=FieldOrDefaultVal(pars["Learning"],"Deduplicate",false);
+
+    reuse_max_=FieldOrDefaultVal(pars["Learning"],"ReuseSamples",0);
+    reuse_threshold_=FieldOrDefaultVal(pars["Learning"],"ReuseThreshold",0.5);
+
+    pipelined_=FieldOrDefaultVal(pars["Learning"],"Pipelined",false);
+
+    adaptive_=FieldOrDefaultVal(pars["Learning"],"AdaptiveSamples",false);
+    minsamples_=FieldOrDefaultVal(pars["Learning"],"MinSamples",nsamples/4.);
+    maxsamples_=FieldOrDefaultVal(pars["Learning"],"MaxSamples",nsamples*4.);
+    target_snr_=FieldOrDefaultVal(pars["Learning"],"TargetSnr",2.);
+    adapt_factor_=FieldOrDefaultVal(pars["Learning"],"AdaptFactor",1.5);
+
+    stop_window_=FieldOrDefaultVal(pars["Learning"],"StopWindow",0);
+    stop_tolerance_=FieldOrDefaultVal(pars["Learning"],"StopTolerance",1.);
+
+    if(adaptive_ && (minsamples_<=0 || maxsamples_<minsamples_ || adapt_factor_<=1)){
+      if(mynode_==0){
+        cerr<<"# Invalid MinSamples, MaxSamples or AdaptFactor"<<endl;
+      }
+      std::abort();
+    }
+
+    if(dedup_ && !psi_.GetHilbert().IsDiscrete()){
+      if(mynode_==0){
+        cerr<<"# Deduplication of samples works only for discrete Hilbert spaces"<<endl;
+      }
+      std::abort();
+    }
+
+    if(exact_){
+      if(!psi_.GetHilbert().IsDiscrete()){
+        if(mynode_==0){
+          cerr<<"# Exact expectation values need a discrete Hilbert space"<<endl;
         }
+        std::abort();
       }
-      else{
-        cout<<"# Using a gradient-descent based method"<<endl;
+
+      if(mynode_==0 && (dedup_ || reuse_max_>0 || pipelined_ || adaptive_ || autosweeps_)){
+        cout<<"# Options controlling the samples are ignored with exact expectation values"<<endl;
       }
+      dedup_=false;
+      reuse_max_=0;
+      pipelined_=false;
+      adaptive_=false;
+      autosweeps_=false;
+
+      EnumerateStates();
+    }
+
+    if(start){
+      Start(pars);
+    }
+  }
+
+  //Prints the options, resumes from the checkpoint if requested, and runs the optimization
+  //followed by the final measurement
+  void Start(const json & pars){
+    if(mynode_==0){
+      PrintOptions();
+    }
+
+    const std::string file_base=FieldVal(pars["Learning"],"OutputFile");
+    const double freqbackup=FieldOrDefaultVal(pars["Learning"],"SaveEvery",100.);
+    const double freqcheckpoint=FieldOrDefaultVal(pars["Learning"],"CheckpointEvery",0.);
+    const bool restart=FieldOrDefaultVal(pars["Learning"],"Restart",false);
+    const int niter_opt=FieldVal(pars["Learning"],"NiterOpt");
+
+    if(restart){
+      Restart(file_base);
+    }
+
+    SetOutName(file_base,freqbackup);
+    SetCheckpoint(file_base,freqcheckpoint);
+
+    Run(NsamplesOption(pars),niter_opt);
+
+    if(final_nsamples_>0){
+      MeasureFinal(final_nsamples_);
+    }
+  }
+
+  //Number of samples per iteration, which is not needed when the expectation values are exact
+  int NsamplesOption(const json & pars)const{
+    if(exact_){
+      return FieldOrDefaultVal(pars["Learning"],"Nsamples",0);
     }
+    return FieldVal(pars["Learning"],"Nsamples");
+  }
 
-    Run(nsamples,niter_opt);
+  //Prints the options of the optimization, on the root node
+  void PrintOptions(){
+    PrintMethod();
+    if(autosweeps_){
+      cout<<"# Sweeps per sample are tuned every "<<tune_every_<<" iterations"<<endl;
+    }
+    if(dedup_){
+      cout<<"# Identical samples are evaluated only once"<<endl;
+    }
+    if(streaming_){
+      cout<<"# Gradient and S matrix are accumulated in chunks of "<<chunk_size_<<" samples"<<endl;
+    }
+    if(reuse_max_>0){
+      cout<<"# Samples are reused for at most "<<reuse_max_<<" iterations, ";
+      cout<<"with effective sample fraction above "<<reuse_threshold_<<endl;
+    }
+    if(pipelined_){
+      cout<<"# Samples of the next iteration are generated while the parameters are updated"<<endl;
+    }
+    if(adaptive_){
+      cout<<"# The number of samples is adapted between "<<minsamples_<<" and "<<maxsamples_;
+      cout<<", with target signal-to-noise ratio "<<target_snr_<<endl;
+    }
+    if(stop_window_>0){
+      cout<<"# The optimization stops when the energy is constant over "<<stop_window_<<" iterations"<<endl;
+    }
+    if(exact_){
+      cout<<"# Expectation values are summed exactly over "<<psi_.GetHilbert().Dimension();
+      cout<<" configurations, using "<<nthreads_<<" threads in each process"<<endl;
+      cout<<"# By default, the cores of a node are divided among its processes"<<endl;
+    }
   }
 
+  //Prints the options of the method used to update the parameters
+  virtual void PrintMethod(){
+    if(dosr_){
+      cout<<"# Using the Stochastic reconfiguration method"<<endl;
+      if(use_iterative_){
+        cout<<"# With iterative solver"<<endl;
+        if(use_jacobi_){
+          cout<<"# Using Jacobi preconditioning"<<endl;
+        }
+        if(single_precision_){
+          cout<<"# Derivatives are stored in single precision"<<endl;
+        }
+      }
+      else if(solver_type_=="SampleSpace"){
+        cout<<"# With direct solver in the space of samples"<<endl;
+      }
+      else if(solver_type_=="Auto"){
+        cout<<"# With direct solver in the space of samples or parameters, whichever is smaller"<<endl;
+      }
+      else if(solver_type_=="BlockDiagonal"){
+        cout<<"# With block-diagonal approximation of the S matrix, using "<<blocks_.size()<<" blocks"<<endl;
+      }
+      if(solver_type_=="ParameterSpace" || solver_type_=="Auto" || solver_type_=="BlockDiagonal"){
+        cout<<"# Using "<<dense_solver_.Type()<<" for the S matrix"<<endl;
+        if(max_update_norm_>0){
+          cout<<"# The diagonal shift is increased while the norm of the update exceeds "<<max_update_norm_<<endl;
+        }
+        if(solve_on_root_){
+          cout<<"# The S matrix is solved on the root node only"<<endl;
+        }
+      }
+    }
+    else{
+      cout<<"# Using a gradient-descent based method"<<endl;
+    }
+  }
 
   void Init(){
     npar_=psi_.Npar();
@@ -135,12 +550,70 @@ public:
     opt_.Init(psi_.GetParameters());
 
     grad_.resize(npar_);
-    Okmean_.resize(npar_);
+    gradprev_=VectorXcd::Zero(npar_);
+    Okmean_=VectorT::Zero(npar_);
+    elocmean_=0;
 
     Iter0_=0;
 
     freqbackup_=0;
 
+    freqcheckpoint_=0;
+    iterstart_=0;
+
+    logformat_="Json";
+    logkeep_=-1;
+
+    measure_.assign(obs_.Size()+1,true);
+    dedicated_.assign(obs_.Size(),false);
+    final_nsamples_=0;
+
+    sweeps_per_sample_=1;
+    autosweeps_=false;
+    tune_every_=10;
+    tune_nsweeps_=512;
+    max_sweeps_per_sample_=64;
+    tune_logpsi_=false;
+
+    dedup_=false;
+
+    use_jacobi_=true;
+    warm_start_=true;
+    single_precision_=false;
+    max_update_norm_=0;
+    shift_retries_=5;
+    solve_on_root_=false;
+
+    streaming_=false;
+    chunk_size_=256;
+
+    exact_=false;
+    nexact_=0;
+    nthreads_=1;
+
+    reuse_max_=0;
+    reuse_threshold_=0.5;
+    nreused_=0;
+    ess_=0;
+
+    pipelined_=false;
+    prefetched_=false;
+    nextsweeps_=0;
+
+    adaptive_=false;
+    nsamples_=0;
+    minsamples_=0;
+    maxsamples_=0;
+    target_snr_=2;
+    adapt_factor_=1.5;
+    gradnoise_=0;
+    gradsnr_=0;
+    srnorm_=0;
+    srnormprev_=0;
+
+    stop_window_=0;
+    stop_tolerance_=1;
+
     setSrParameters();
 
     obsmanager_.AddObservable("Energy",double());
@@ -160,238 +633,1345 @@ public:
   }
 
   void Sample(double nsweeps){
+    if(exact_){
+      ExactWeights();
+      return;
+    }
+
+    DrawSamples(nsweeps,vsamp_,logvsamp_);
+
+    const int sweepnode=vsamp_.rows();
+
+    weights_=VectorXd::Ones(sweepnode);
+    nreused_=0;
+    ess_=sweepnode*totalnodes_;
+  }
+
+  //Generates the samples of this node with the current parameters.
+  //No communication is done, so that it can run in a separate thread
+  void DrawSamples(double nsweeps,MatrixXd & vsamp,VectorT & logvsamp){
     sampler_.Reset();
 
     int sweepnode=int(std::ceil(double(nsweeps)/double(totalnodes_)));
 
-    vsamp_.resize(sweepnode,psi_.Nvisible());
+    vsamp.resize(sweepnode,psi_.Nvisible());
+    logvsamp.resize(sweepnode);
 
     for(int i=0;i<sweepnode;i++){
-      sampler_.Sweep();
-      vsamp_.row(i)=sampler_.Visible();
+      for(int s=0;s<sweeps_per_sample_;s++){
+        sampler_.Sweep();
+      }
+      vsamp.row(i)=sampler_.Visible();
+      logvsamp(i)=sampler_.LogVal();
     }
   }
 
-  //Sets the name of the files on which the logs and the wave-function parameters are saved
-  //the wave-function is saved every freq steps
-  void SetOutName(string filebase, double freq=50){
-    filelog_.open(filebase+string(".log"));
-    freqbackup_=freq;
+  //Assigns to each node a contiguous range of the configurations of the Hilbert space.
+  //All the nodes store the same number of rows, and the missing ones
+  //are filled with a copy of the last configuration, which is given zero weight
+  void EnumerateStates(){
+    const auto & hilbert=psi_.GetHilbert();
+    const long dim=hilbert.Dimension();
+
+    const long nrows=(dim+totalnodes_-1)/totalnodes_;
+    if(dim==0 || nrows>=std::numeric_limits<int>::max()){
+      if(mynode_==0){
+        cerr<<"# Cannot sum over "<<dim<<" configurations"<<endl;
+      }
+      std::abort();
+    }
 
-    filewfname_=filebase+string(".wf");
-  }
+    const long first=std::min(dim,mynode_*nrows);
+    nexact_=std::min(dim,first+nrows)-first;
 
-  void Gradient(){
+    vsamp_.resize(nrows,psi_.Nvisible());
+    logvsamp_.resize(nrows);
 
-    obsmanager_.Reset("Energy");
-    obsmanager_.Reset("EnergyVariance");
+    ParallelFor(nthreads_,nrows,[&](long begin,long end,int){
+      VectorXd v;
+      for(long i=begin;i<end;i++){
+        hilbert.IndexToState(std::min(first+i,dim-1),v);
+        vsamp_.row(i)=v;
+      }
+    });
 
-    for(int i=0;i<obs_.Size();i++){
-      obsmanager_.Reset(obs_(i).Name());
+    clones_.resize(nthreads_);
+    evaluators_.resize(nthreads_);
+    for(int t=0;t<nthreads_;t++){
+      clones_[t].reset(psi_.Clone());
+      evaluators_[t].reset(new Evaluator(ham_,obs_,*clones_[t]));
     }
+  }
 
-    const int nsamp=vsamp_.rows();
-    elocs_.resize(nsamp);
-    Ok_.resize(nsamp,psi_.Npar());
+  //Computes the weights of the configurations for the current parameters, proportional to |Psi|^2.
+  //They are normalized as importance-sampling weights, with sum equal to the total number of rows
+  void ExactWeights(){
+    const int nrows=vsamp_.rows();
 
-    for(int i=0;i<nsamp;i++){
-      elocs_(i)=Eloc(vsamp_.row(i));
-      Ok_.row(i)=psi_.DerLog(vsamp_.row(i));
-      obsmanager_.Push("Energy",elocs_(i).real());
+    const auto pars=psi_.GetParameters();
+    for(auto & clone : clones_){
+      clone->SetParameters(pars);
+    }
 
-      for(int k=0;k<obs_.Size();k++){
-        obsmanager_.Push(obs_(k).Name(),ObSamp(obs_(k),vsamp_.row(i)));
+    ParallelFor(nthreads_,nrows,[&](long begin,long end,int t){
+      for(long i=begin;i<end;i++){
+        logvsamp_(i)=clones_[t]->LogVal(vsamp_.row(i));
       }
+    });
+
+    VectorXd logw(nrows);
+    for(int i=0;i<nrows;i++){
+      logw(i)=2.*real_part(logvsamp_(i));
     }
 
-    elocmean_=elocs_.mean();
-    SumOnNodes(elocmean_);
-    elocmean_/=double(totalnodes_);
+    double maxlogw=(nexact_>0)?logw.head(nexact_).maxCoeff():-std::numeric_limits<double>::max();
+    MaxOnNodes(maxlogw);
 
-    Okmean_=Ok_.colwise().mean();
-    SumOnNodes(Okmean_);
-    Okmean_/=double(totalnodes_);
+    VectorXd w=(logw.array()-maxlogw).exp();
+    w.tail(nrows-nexact_).setZero();
 
-    Ok_=Ok_.rowwise()-Okmean_.transpose();
+    double sum=w.sum();
+    SumOnNodes(sum);
 
-    elocs_-=elocmean_*VectorXd::Ones(nsamp);
+    weights_=w*(double(nrows*totalnodes_)/sum);
+    nreused_=0;
+    ess_=nrows*totalnodes_;
+  }
 
-    for(int i=0;i<nsamp;i++){
-      obsmanager_.Push("EnergyVariance",std::norm(elocs_(i)));
+  //Reweights the current samples to the distribution given by the current parameters
+  //Returns false if the samples cannot be reused, and new ones must be generated
+  bool ReuseSamples(){
+    if(reuse_max_<=0 || nreused_>=reuse_max_ || vsamp_.rows()==0){
+      return false;
     }
 
-    grad_=2.*(Ok_.adjoint()*elocs_);
-
-    //Summing the gradient over the nodes
-    SumOnNodes(grad_);
-    grad_/=double(totalnodes_*nsamp);
+    if(!Reweight()){
+      return false;
+    }
 
+    nreused_++;
+    return true;
   }
 
+  //Computes the importance-sampling weights of the current samples for the current parameters
+  //Returns false if the effective sample fraction is below the threshold
+  bool Reweight(){
+    const int nsamp=vsamp_.rows();
 
-  std::complex<double> Eloc(const VectorXd & v){
-
-    ham_.FindConn(v,mel_,connectors_,newconfs_);
+    //logarithm of |psi_new/psi_old|^2, where psi_old is the one used for sampling
+    VectorXd logw(nsamp);
+    for(int i=0;i<nsamp;i++){
+      logw(i)=2.*real_part(psi_.LogVal(vsamp_.row(i))-logvsamp_(i));
+    }
 
-    assert(connectors_.size()==mel_.size());
+    double maxlogw=logw.maxCoeff();
+    MaxOnNodes(maxlogw);
 
-    auto logvaldiffs=(psi_.LogValDiff(v,connectors_,newconfs_));
+    VectorXd w=(logw.array()-maxlogw).exp();
 
-    assert(mel_.size()==logvaldiffs.size());
+    double sums[2]={w.sum(),w.squaredNorm()};
+    SumOnNodes(sums,2);
 
-    std::complex<double> eloc=0;
+    //effective sample size
+    const double nsamptot=double(nsamp*totalnodes_);
+    const double ess=sums[0]*sums[0]/sums[1];
 
-    for(int i=0;i<logvaldiffs.size();i++){
-      eloc+=mel_[i]*std::exp(logvaldiffs(i));
+    if(ess<reuse_threshold_*nsamptot){
+      return false;
     }
 
-    return eloc;
+    weights_=w*(nsamptot/sums[0]);
+    ess_=ess;
+    return true;
   }
 
-  double ObSamp(Observable & ob,const VectorXd & v){
-    ob.FindConn(v,mel_,connectors_,newconfs_);
+  //Measures the integrated auto-correlation time of the local energy
+  //(and optionally of log|psi|) along the Markov chains, in units of sweeps,
+  //and sets the number of sweeps between recorded samples accordingly
+  void TuneSweeps(){
+    sampler_.Reset();
 
-    assert(connectors_.size()==mel_.size());
+    Binning<double> eloc_bins;
+    Binning<double> logpsi_bins;
 
-    auto logvaldiffs=(psi_.LogValDiff(v,connectors_,newconfs_));
+    for(int i=0;i<tune_nsweeps_;i++){
+      sampler_.Sweep();
+      const auto v=sampler_.Visible();
 
-    assert(mel_.size()==logvaldiffs.size());
+      eloc_bins<<Eloc(v).real();
+      if(tune_logpsi_){
+        logpsi_bins<<real_part(sampler_.LogVal());
+      }
+    }
 
-    std::complex<double> obval=0;
+    //the auto-correlation time of a quantity with zero variance is not defined (NaN)
+    double tau=eloc_bins.TauCorr();
+    if(tune_logpsi_){
+      const double taupsi=logpsi_bins.TauCorr();
+      if(!std::isfinite(tau) || taupsi>tau){
+        tau=taupsi;
+      }
+    }
 
-    for(int i=0;i<logvaldiffs.size();i++){
-      obval+=mel_[i]*std::exp(logvaldiffs(i));
+    //samples separated by 1+2*tau sweeps are nearly independent.
+    //If no auto-correlation time is defined, the samples are not correlated
+    double sweeps=1;
+    if(std::isfinite(tau)){
+      sweeps=std::ceil(1.+2.*std::max(tau,0.));
     }
+    sweeps=std::min(sweeps,double(max_sweeps_per_sample_));
+    sweeps_per_sample_=int(std::max(sweeps,1.));
 
-    return obval.real();
+    if(mynode_==0){
+      if(std::isfinite(tau)){
+        cout<<"# Auto-correlation time is "<<tau<<" sweeps, using ";
+      }
+      else{
+        cout<<"# Auto-correlation time is not defined, using ";
+      }
+      cout<<sweeps_per_sample_<<" sweeps per sample"<<endl;
+    }
   }
 
+  //Sets the name of the files on which the logs and the wave-function parameters are saved
+  //the wave-function is saved every freq steps
+  void SetOutName(string filebase, double freq=50){
+    writer_.Flush();
 
-  double ElocMean(){
-    return elocmean_.real();
+    //the output of the previous iterations is kept when resuming
+    if(mynode_==0){
+      logwriter_.Open(filebase+string(".log"),logformat_,logkeep_);
+    }
+    logkeep_=-1;
+
+    freqbackup_=freq;
+
+    filewfname_=filebase+string(".wf");
   }
 
-  double Elocvar(){
-    return elocvar_;
+  //Sets the name of the checkpoint file, which is written every freq steps
+  void SetCheckpoint(string filebase, double freq){
+    filecheckpoint_=filebase+string(".ckpt");
+    freqcheckpoint_=freq;
+
+    if(mynode_==0 && freqcheckpoint_>0){
+      cout<<"# Checkpoints are written every "<<freqcheckpoint_<<" iterations to "<<filecheckpoint_<<endl;
+    }
   }
 
-  void Run(double nsweeps,double niter){
-    opt_.Reset();
+  //Writes the state of the optimization needed to continue it exactly:
+  //parameters, stepper, sampler and samples, random number generators.
+  //iter is the index of the next iteration of the current Run
+  void SaveCheckpoint(double iter){
+    //the log must contain all the iterations before the checkpoint
+    writer_.Flush();
+
+    BinaryWriter shared;
+    BinaryWriter local;
+
+    shared.Write(Iter0_);
+    shared.Write(iter);
+    shared.Write(psi_.GetParameters());
+    opt_.SaveState(shared);
+    shared.Write(sweeps_per_sample_);
+    shared.Write(gradprev_);
+    shared.Write(Okmean_);
+    shared.Write(elocmean_);
+    shared.Write(nsamples_);
+    shared.Write(srnorm_);
+    shared.Write(srnormprev_);
+    shared.Write(ehist_);
+    shared.Write(esigma_);
+    shared.Write(varhist_);
+    shared.Write(varsigma_);
+    SaveMethodState(shared);
+
+    sampler_.SaveState(local);
+    local.Write(vsamp_);
+    local.Write(logvsamp_);
+    local.Write(weights_);
+    local.Write(nreused_);
+    local.Write(ess_);
+    local.Write(prefetched_);
+
+    CheckpointFile::Save(filecheckpoint_,shared,local);
+  }
 
-    for(double i=0;i<niter;i++){
-      Sample(nsweeps);
+  void LoadCheckpoint(string filename){
+    BinaryReader shared;
+    BinaryReader local;
 
-      Gradient();
+    CheckpointFile::Load(filename,shared,local);
 
-      UpdateParameters();
+    shared.Read(Iter0_);
+    shared.Read(iterstart_);
 
-      PrintOutput(i);
+    VectorT pars;
+    shared.Read(pars);
+    if(pars.size()!=npar_){
+      if(mynode_==0){
+        cerr<<"# The checkpoint has "<<pars.size()<<" parameters, instead of "<<npar_<<endl;
+      }
+      std::abort();
     }
-    Iter0_+=niter;
-  }
+    psi_.SetParameters(pars);
 
+    opt_.LoadState(shared);
+    shared.Read(sweeps_per_sample_);
+    shared.Read(gradprev_);
+    shared.Read(Okmean_);
+    shared.Read(elocmean_);
+    shared.Read(nsamples_);
+    shared.Read(srnorm_);
+    shared.Read(srnormprev_);
+    shared.Read(ehist_);
+    shared.Read(esigma_);
+    shared.Read(varhist_);
+    shared.Read(varsigma_);
+    LoadMethodState(shared);
+
+    sampler_.LoadState(local);
+    local.Read(vsamp_);
+    local.Read(logvsamp_);
+    local.Read(weights_);
+    local.Read(nreused_);
+    local.Read(ess_);
+    local.Read(prefetched_);
+  }
 
-  void UpdateParameters(){
+  //Writes and reads the state specific to the method, in the shared part of the checkpoint
+  virtual void SaveMethodState(BinaryWriter & shared){}
+  virtual void LoadMethodState(BinaryReader & shared){}
 
-    auto pars=psi_.GetParameters();
+  //Resumes the optimization from the checkpoint with the given base name, if it exists,
+  //restoring the log of the iterations done before it was written
+  void Restart(string filebase){
+    const string filename=filebase+string(".ckpt");
 
-    if(dosr_){
+    if(!CheckpointFile::Exists(filename)){
+      if(mynode_==0){
+        cout<<"# No checkpoint found in "<<filename<<", starting a new optimization"<<endl;
+      }
+      return;
+    }
 
-      const int nsamp=vsamp_.rows();
+    LoadCheckpoint(filename);
 
-      VectorXcd b=Ok_.adjoint()*elocs_;
-      SumOnNodes(b);
-      b/=double(nsamp*totalnodes_);
+    //iterations logged after the checkpoint are discarded, since they are repeated
+    logkeep_=Iter0_+iterstart_;
 
-      if(!use_iterative_){
+    if(mynode_==0){
+      cout<<"# Restarting from the checkpoint "<<filename<<" at iteration "<<Iter0_+iterstart_<<endl;
+    }
+  }
 
-        //Explicit construction of the S matrix
-        MatrixXcd S=Ok_.adjoint()*Ok_;
-        SumOnNodes(S);
-        S/=double(nsamp*totalnodes_);
+  void Gradient(){
 
-        //Adding diagonal shift
-        S+=MatrixXd::Identity(pars.size(),pars.size())*sr_diag_shift_;
+    obsmanager_.Reset("Energy");
+    obsmanager_.Reset("EnergyVariance");
 
-        FullPivHouseholderQR<MatrixXcd> qr(S.rows(), S.cols());
-        qr.setThreshold(1.0e-6);
-        qr.compute(S);
-        const VectorXcd deltaP=qr.solve(b);
-        // VectorXcd deltaP=S.jacobiSvd(ComputeThinU | ComputeThinV).solve(b);
+    for(int i=0;i<obs_.Size();i++){
+      obsmanager_.Reset(obs_(i).Name());
+    }
 
-        assert(deltaP.size()==grad_.size());
-        grad_=deltaP;
+    const int nsamp=vsamp_.rows();
 
-        if(sr_rescale_shift_){
-          complex<double> nor=(deltaP.dot(S*deltaP));
-          grad_/=std::sqrt(nor.real());
-        }
+    FindUnique();
 
-      }
-      else{
-        Eigen::ConjugateGradient<MatrixReplacement, Eigen::Lower|Eigen::Upper, Eigen::IdentityPreconditioner> it_solver;
-        // Eigen::GMRES<MatrixReplacement, Eigen::IdentityPreconditioner> it_solver;
-        it_solver.setTolerance(1.0e-3);
-        MatrixReplacement S;
-        S.attachMatrix(Ok_);
-        S.setShift(sr_diag_shift_);
-        S.setScale(1./double(nsamp*totalnodes_));
-
-        it_solver.compute(S);
-        auto deltaP = it_solver.solve(b);
-
-        grad_=deltaP;
-        if(sr_rescale_shift_){
-          auto nor=deltaP.dot(S*deltaP);
-          grad_/=std::sqrt(nor.real());
-        }
+    const int nuniq=urows_.size();
+    elocs_.resize(nuniq);
+    MatrixXd obvals(nuniq,obs_.Size());
 
-        // if(mynode_==0){
-        //   cerr<<it_solver.iterations()<<"  "<<it_solver.error()<<endl;
-        // }
-        MPI_Barrier(MPI_COMM_WORLD);
-      }
+    if(streaming_){
+      AccumulateStreaming(obvals);
     }
+    else{
+      Ok_.resize(nuniq,psi_.Npar());
+      PrepareSamples(nuniq);
 
-    opt_.Update(grad_,pars);
-
-    SendToAll(pars);
+      EvaluateSamples(0,nuniq,obvals,Ok_);
+    }
 
-    psi_.SetParameters(pars);
-    MPI_Barrier(MPI_COMM_WORLD);
-  }
+    //observables are recorded in the order of the Markov chain
+    for(int i=0;i<nsamp;i++){
+      const int u=uniqueidx_[i];
+      obsmanager_.Push("Energy",weights_(i)*elocs_(u).real());
 
-  void PrintOutput(double i){
-    auto Acceptance=sampler_.Acceptance();
+      for(int k=0;k<obs_.Size();k++){
+        if(measure_[k+1]){
+          obsmanager_.Push(obs_(k).Name(),weights_(i)*obvals(u,k));
+        }
+      }
+    }
 
-    auto jiter=json(obsmanager_);
-    jiter["Iteration"]=i+Iter0_;
-    outputjson_["Output"].push_back(jiter);
+    if(streaming_){
+      FinalizeStreaming();
+      GradientNoise();
 
-    if(mynode_==0){
-      if (jiter["Iteration"]!=0){
-        long pos = filelog_.tellp();
-        filelog_.seekp(pos - 3);
-        filelog_.write(",  ",3);
-        filelog_<<jiter<< "]}"<<endl;
+      for(int i=0;i<nsamp;i++){
+        obsmanager_.Push("EnergyVariance",weights_(i)*std::norm(elocs_(uniqueidx_[i])));
       }
-      else {
-        filelog_<<outputjson_ <<endl;
+      if(exact_){
+        ExactAverages(obvals);
       }
+      return;
     }
 
-    if(mynode_==0 && freqbackup_>0 &&  std::fmod(i,freqbackup_)<0.5){
-      psi_.Save(filewfname_);
-    }
+    //the means of the local energy and of the derivatives are summed with a single reduction
+    VectorXcd sums(npar_+1);
+    sums(0)=(mult_.asDiagonal()*elocs_).sum();
+    sums.tail(npar_)=(mult_.asDiagonal()*Ok_).colwise().sum().transpose().template cast<complex<double>>();
+    SumOnNodes(sums);
+    sums/=double(nsamp*totalnodes_);
 
-    MPI_Barrier(MPI_COMM_WORLD);
-  }
+    elocmean_=sums(0);
+    assign_from_complex(sums.tail(npar_),Okmean_);
 
+    Ok_=Ok_.rowwise()-Okmean_.transpose();
 
-  void setSrParameters(double diagshift=0.01,bool rescale_shift=false,bool use_iterative=false){
-    sr_diag_shift_=diagshift;
+    elocs_-=elocmean_*VectorXd::Ones(nuniq);
+
+    for(int i=0;i<nsamp;i++){
+      obsmanager_.Push("EnergyVariance",weights_(i)*std::norm(elocs_(uniqueidx_[i])));
+    }
+
+    if(exact_){
+      ExactAverages(obvals);
+    }
+
+    if(adaptive_){
+      //sum over the samples of |O_k(v) (E(v)-<E>)|^2, summed over k
+      const VectorXd normok=Ok_.rowwise().squaredNorm().template cast<double>();
+      gradnoise_=(mult_.array()*elocs_.cwiseAbs2().array()*normok.array()).sum();
+    }
+
+    //rescaling by the square root of the weights, so that
+    //the gradient and the S matrix are the usual averages over all the samples.
+    //Samples are weighted when they are reused, or generated with the previous parameters
+    if(dedup_ || (mult_.array()!=1.).any()){
+      for(int u=0;u<nuniq;u++){
+        const double sq=std::sqrt(mult_(u));
+        Ok_.row(u)*=sq;
+        elocs_(u)*=sq;
+      }
+    }
+
+    grad_=2.*(Ok_.adjoint()*elocs_);
+
+    //Summing the gradient over the nodes
+    SumOnNodes(grad_);
+    grad_/=double(totalnodes_*nsamp);
+
+    GradientNoise();
+
+    if(dosr_ && single_precision_){
+      Okf_=Ok_.template cast<StateTypeF>();
+      Ok_.resize(0,0);
+    }
+  }
+
+
+  //Evaluates the local energies, the observables and the derivatives in chunks of samples,
+  //accumulating the sums needed for the gradient and the S matrix.
+  //Derivatives and local energies are shifted by their means at the previous iteration,
+  //to reduce round-off errors when they are centered
+  void AccumulateStreaming(MatrixXd & obvals){
+    const int nuniq=urows_.size();
+
+    const VectorXcd c=Okmean_.template cast<complex<double>>();
+    const complex<double> e0=elocmean_;
+
+    if(dosr_){
+      Sacc_=MatrixXcd::Zero(npar_,npar_);
+    }
+    streamsums_=VectorXcd::Zero(2*npar_+1);
+    gradnoise_=0;
+
+    MatrixT Okt(chunk_size_,npar_);
+    MatrixXcd Okc(chunk_size_,npar_);
+    VectorXcd ec(chunk_size_);
+    VectorXd sqc(chunk_size_);
+
+    for(int u0=0;u0<nuniq;u0+=chunk_size_){
+      const int nc=std::min(chunk_size_,nuniq-u0);
+
+      EvaluateSamples(u0,nc,obvals,Okt);
+
+      for(int r=0;r<nc;r++){
+        const int u=u0+r;
+        sqc(r)=std::sqrt(mult_(u));
+        Okc.row(r)=sqc(r)*(Okt.row(r).template cast<complex<double>>()-c.transpose());
+        ec(r)=sqc(r)*(elocs_(u)-e0);
+        streamsums_(0)+=mult_(u)*elocs_(u);
+
+        //the noise of the gradient is estimated with the means of the previous iteration
+        if(adaptive_){
+          gradnoise_+=Okc.row(r).squaredNorm()*std::norm(elocs_(u)-e0);
+        }
+      }
+
+      const auto Ob=Okc.topRows(nc);
+
+      if(dosr_){
+        Sacc_.selfadjointView<Lower>().rankUpdate(Ob.adjoint());
+      }
+      streamsums_.segment(1,npar_)+=Ob.transpose()*sqc.head(nc);
+      streamsums_.tail(npar_)+=Ob.adjoint()*ec.head(nc);
+    }
+  }
+
+  //Computes the exact averages of the energy, of its variance and of the observables,
+  //which replace the binned statistics of the samples in exact mode.
+  //The local energies must be already centered
+  void ExactAverages(const MatrixXd & obvals){
+    VectorXd sums(obs_.Size()+2);
+    sums(0)=0;
+    sums(1)=mult_.dot(elocs_.cwiseAbs2());
+    sums.tail(obs_.Size())=obvals.transpose()*mult_;
+    SumOnNodes(sums);
+
+    exactvals_=sums/double(vsamp_.rows()*totalnodes_);
+    exactvals_(0)=elocmean_.real();
+  }
+
+  //Evaluates the local energies, the observables and the derivatives of the distinct samples
+  //from u0 to u0+n-1, storing the derivatives in the first n rows of ok.
+  //In exact mode the samples are split among the threads
+  void EvaluateSamples(int u0,int n,MatrixXd & obvals,MatrixT & ok){
+    if(!exact_){
+      for(int r=0;r<n;r++){
+        EvaluateSample(psi_,evaluator_,u0+r,obvals,ok.row(r));
+      }
+      return;
+    }
+
+    ParallelFor(nthreads_,n,[&](long begin,long end,int t){
+      for(long r=begin;r<end;r++){
+        EvaluateSample(*clones_[t],*evaluators_[t],u0+r,obvals,ok.row(r));
+      }
+    });
+  }
+
+  //Computes the local energy, the local values of the observables measured in this iteration
+  //and the derivatives of the u-th distinct sample, using the given machine and evaluator
+  template<class Machine,class Row> void EvaluateSample(Machine & psi,Evaluator & evaluator,
+      int u,MatrixXd & obvals,Row ok){
+    const VectorXd v=vsamp_.row(urows_[u]);
+
+    VectorXcd values;
+    evaluator.Evaluate(v,values,measure_);
+    elocs_(u)=values(0);
+    obvals.row(u)=values.tail(obs_.Size()).real().transpose();
+
+    const VectorT derlog=psi.DerLog(v);
+    ok=derlog.transpose();
+
+    SampleEvaluated(evaluator,u,v,derlog);
+  }
+
+  //Called before the nuniq distinct samples are evaluated, when the derivatives are stored
+  virtual void PrepareSamples(int nuniq){}
+
+  //Called after the u-th distinct sample v is evaluated, where derlog are its derivatives
+  //and the evaluator holds its connections. In exact mode, it is called by several threads
+  //with different samples
+  virtual void SampleEvaluated(Evaluator & evaluator,int u,const VectorXd & v,const VectorT & derlog){}
+
+  //Sums the accumulated quantities over the nodes, and centers them
+  void FinalizeStreaming(){
+    const double ntot=double(vsamp_.rows()*totalnodes_);
+
+    //shifts used in the accumulation
+    const VectorXcd c=Okmean_.template cast<complex<double>>();
+    const complex<double> e0=elocmean_;
+
+    SumOnNodes(streamsums_);
+
+    elocmean_=streamsums_(0)/ntot;
+
+    const VectorXcd d=streamsums_.segment(1,npar_)/ntot;
+    assign_from_complex(c+d,Okmean_);
+
+    grad_=2.*(streamsums_.tail(npar_)/ntot-d.conjugate()*(elocmean_-e0));
+
+    //centering of the S matrix, done on one node since Sacc_ is later summed over the nodes
+    if(dosr_ && mynode_==0){
+      Sacc_.selfadjointView<Lower>().rankUpdate(d.conjugate(),-ntot);
+    }
+
+    elocs_-=elocmean_*VectorXd::Ones(elocs_.size());
+  }
+
+  //Finds the distinct configurations among the samples
+  //and the sum of the weights of the samples where each of them appears
+  void FindUnique(){
+    const int nsamp=vsamp_.rows();
+
+    urows_.clear();
+    uniqueidx_.resize(nsamp);
+
+    if(!dedup_){
+      for(int i=0;i<nsamp;i++){
+        urows_.push_back(i);
+        uniqueidx_[i]=i;
+      }
+      mult_=weights_;
+      return;
+    }
+
+    //distinct configurations having a given hash
+    std::unordered_map<uint64_t,vector<int>> buckets;
+    vector<double> mult;
+
+    for(int i=0;i<nsamp;i++){
+      auto & bucket=buckets[hasher_(vsamp_.row(i))];
+
+      int found=-1;
+      for(auto u : bucket){
+        if(vsamp_.row(urows_[u])==vsamp_.row(i)){
+          found=u;
+          break;
+        }
+      }
+
+      if(found<0){
+        found=urows_.size();
+        bucket.push_back(found);
+        urows_.push_back(i);
+        mult.push_back(0);
+      }
+
+      uniqueidx_[i]=found;
+      mult[found]+=weights_(i);
+    }
+
+    mult_=Map<VectorXd>(mult.data(),mult.size());
+  }
+
+  std::complex<double> Eloc(const VectorXd & v){
+
+    ham_.FindConn(v,mel_,connectors_,newconfs_);
+
+    assert(connectors_.size()==mel_.size());
+
+    auto logvaldiffs=(psi_.LogValDiff(v,connectors_,newconfs_));
+
+    assert(mel_.size()==logvaldiffs.size());
+
+    std::complex<double> eloc=0;
+
+    for(int i=0;i<logvaldiffs.size();i++){
+      eloc+=mel_[i]*std::exp(logvaldiffs(i));
+    }
+
+    return eloc;
+  }
+
+  //Computes the signal-to-noise ratio of the gradient, as the ratio between its norm
+  //and the norm of its statistical error, estimated from the local noise summed by Gradient
+  void GradientNoise(){
+    if(!adaptive_){
+      return;
+    }
+
+    SumOnNodes(gradnoise_);
+
+    const double ntot=double(vsamp_.rows()*totalnodes_);
+    const double gnorm2=grad_.squaredNorm();
+
+    //variance of the mean of 2 O_k^* (E-<E>), summed over k
+    const double noise2=std::max(4.*gradnoise_/ntot-gnorm2,0.)/ntot;
+
+    gradsnr_=(noise2>0)?std::sqrt(gnorm2/noise2):std::numeric_limits<double>::max();
+  }
+
+  //Changes the number of samples of the next iterations.
+  //More samples are used when the gradient is dominated by noise,
+  //and fewer when it is well resolved and the SR solution is not growing
+  void AdaptSamples(){
+    double nsamples=nsamples_;
+
+    if(gradsnr_<target_snr_){
+      nsamples*=adapt_factor_;
+    }
+    else if(gradsnr_>2.*target_snr_ && srnorm_<=srnormprev_){
+      nsamples/=adapt_factor_;
+    }
+
+    nsamples_=std::min(std::max(nsamples,minsamples_),maxsamples_);
+  }
+
+  //Returns true if the mean energy and the energy variance of the first and second half
+  //of the last stop_window_ iterations agree within stop_tolerance_ error bars.
+  //Exact expectation values have no error bars, and stop_tolerance_ is an absolute tolerance
+  bool Converged(){
+    if(exact_){
+      ehist_.push_back(exactvals_(0));
+      esigma_.push_back(0);
+      varhist_.push_back(exactvals_(1));
+      varsigma_.push_back(0);
+    }
+    else{
+      const json je=obsmanager_.AllStats("Energy");
+      const json jv=obsmanager_.AllStats("EnergyVariance");
+
+      ehist_.push_back(je["Mean"]);
+      esigma_.push_back(je["Sigma"]);
+      varhist_.push_back(jv["Mean"]);
+      varsigma_.push_back(jv["Sigma"]);
+    }
+
+    if(int(ehist_.size())>stop_window_){
+      ehist_.erase(ehist_.begin());
+      esigma_.erase(esigma_.begin());
+      varhist_.erase(varhist_.begin());
+      varsigma_.erase(varsigma_.begin());
+    }
+
+    if(int(ehist_.size())<stop_window_ || stop_window_<2){
+      return false;
+    }
+
+    return Stable(ehist_,esigma_) && Stable(varhist_,varsigma_);
+  }
+
+  bool Stable(const vector<double> & val,const vector<double> & sigma)const{
+    const int nhalf=val.size()/2;
+    const int off=val.size()-nhalf;
+
+    double mean1=0;
+    double mean2=0;
+    double sig1=0;
+    double sig2=0;
+    for(int i=0;i<nhalf;i++){
+      mean1+=val[i];
+      mean2+=val[off+i];
+      sig1+=sigma[i]*sigma[i];
+      sig2+=sigma[off+i]*sigma[off+i];
+    }
+    mean1/=double(nhalf);
+    mean2/=double(nhalf);
+
+    const double err=exact_?1.:std::sqrt(sig1+sig2)/double(nhalf);
+
+    return std::abs(mean1-mean2)<=stop_tolerance_*err;
+  }
+
+  //Decides which observables are measured at the given iteration,
+  //and whether they use the samples of the gradient or dedicated ones
+  void ScheduleMeasurements(double iter){
+    for(int k=0;k<obs_.Size();k++){
+      const double every=obs_(k).MeasureEvery();
+      const bool due=(every>0 && std::fmod(iter,every)<0.5);
+
+      dedicated_[k]=due && obs_(k).Nsamples()>0;
+      measure_[k+1]=due && !dedicated_[k];
+    }
+  }
+
+  //Measures the observables which use dedicated samples, continuing the Markov chain.
+  //The derivatives of the wave-function are not computed
+  void MeasureDedicated(){
+    vector<bool> active(obs_.Size()+1,false);
+    vector<int> nsampnode(obs_.Size(),0);
+    int nmax=0;
+
+    for(int k=0;k<obs_.Size();k++){
+      if(dedicated_[k]){
+        active[k+1]=true;
+        nsampnode[k]=int(std::ceil(obs_(k).Nsamples()/double(totalnodes_)));
+        nmax=std::max(nmax,nsampnode[k]);
+      }
+    }
+
+    if(nmax==0){
+      return;
+    }
+
+    sampler_.Reset();
+
+    VectorXcd values;
+    for(int i=0;i<nmax;i++){
+      for(int s=0;s<sweeps_per_sample_;s++){
+        sampler_.Sweep();
+      }
+      evaluator_.Evaluate(sampler_.Visible(),values,active);
+
+      for(int k=0;k<obs_.Size();k++){
+        if(i<nsampnode[k]){
+          obsmanager_.Push(obs_(k).Name(),values(k+1).real());
+        }
+      }
+    }
+  }
+
+  //Measures the energy and all the observables on new samples, after the optimization.
+  //The results are written in the log, and printed by the root node
+  void MeasureFinal(double nsamples){
+    ObsManager obsmanager;
+    obsmanager.AddObservable("Energy",double());
+    obsmanager.AddObservable("EnergyVariance",double());
+    for(int k=0;k<obs_.Size();k++){
+      obsmanager.AddObservable(obs_(k).Name(),double());
+    }
+
+    const int nsampnode=int(std::ceil(nsamples/double(totalnodes_)));
+
+    sampler_.Reset();
+
+    VectorXcd values;
+    VectorXcd elocs(nsampnode);
+    for(int i=0;i<nsampnode;i++){
+      for(int s=0;s<sweeps_per_sample_;s++){
+        sampler_.Sweep();
+      }
+      evaluator_.Evaluate(sampler_.Visible(),values);
+
+      elocs(i)=values(0);
+      obsmanager.Push("Energy",values(0).real());
+      for(int k=0;k<obs_.Size();k++){
+        obsmanager.Push(obs_(k).Name(),values(k+1).real());
+      }
+    }
+
+    complex<double> elocmean=elocs.sum();
+    SumOnNodes(elocmean);
+    elocmean/=double(nsampnode*totalnodes_);
+
+    for(int i=0;i<nsampnode;i++){
+      obsmanager.Push("EnergyVariance",std::norm(elocs(i)-elocmean));
+    }
+
+    auto jout=json(obsmanager);
+    jout["Iteration"]=Iter0_;
+    jout["FinalMeasurement"]=nsampnode*totalnodes_;
+
+    if(mynode_==0){
+      cout<<"# Final measurement on "<<nsampnode*totalnodes_<<" samples"<<endl;
+      for(const auto & name : obsmanager.Names()){
+        cout<<"# "<<name<<" = "<<jout[name]["Mean"]<<" +/- "<<jout[name]["Sigma"]<<endl;
+      }
+
+      writer_.Push([this,jout](){
+        logwriter_.Write(jout);
+      });
+    }
+    writer_.Flush();
+  }
+
+  double ElocMean(){
+    return elocmean_.real();
+  }
+
+  double Elocvar(){
+    return elocvar_;
+  }
+
+  void Run(double nsweeps,double niter){
+    //the state of the stepper is kept when resuming from a checkpoint
+    if(iterstart_==0){
+      opt_.Reset();
+    }
+
+    //the number of samples is kept when resuming from a checkpoint
+    if(iterstart_==0 || nsamples_<=0){
+      nsamples_=nsweeps;
+      srnorm_=0;
+      srnormprev_=0;
+      ehist_.clear();
+      esigma_.clear();
+      varhist_.clear();
+      varsigma_.clear();
+    }
+
+    double niterdone=niter;
+
+    for(double i=iterstart_;i<niter;i++){
+      if(autosweeps_ && std::fmod(i,tune_every_)<0.5){
+        TuneSweeps();
+      }
+
+      if(prefetched_){
+        //the samples generated during the previous update are reweighted to the current parameters
+        prefetched_=false;
+        if(!Reweight()){
+          Sample(nsamples_);
+        }
+      }
+      else if(!ReuseSamples()){
+        Sample(nsamples_);
+      }
+
+      ScheduleMeasurements(i+Iter0_);
+
+      Gradient();
+
+      MeasureDedicated();
+
+      nextsweeps_=(pipelined_ && i+1<niter)?nsamples_:0;
+
+      UpdateParameters();
+
+      //the adaptation uses the norm of the update just computed.
+      //Pipelined samples are drawn during the update, so they follow it one iteration later
+      if(adaptive_){
+        AdaptSamples();
+      }
+
+      PrintOutput(i);
+
+      const bool converged=(stop_window_>0 && Converged());
+
+      if(freqcheckpoint_>0 && std::fmod(i+1,freqcheckpoint_)<0.5){
+        SaveCheckpoint(i+1);
+      }
+
+      if(converged){
+        if(mynode_==0){
+          cout<<"# Energy converged after "<<i+1+Iter0_<<" iterations"<<endl;
+        }
+        niterdone=i+1;
+        break;
+      }
+    }
+    Iter0_+=niterdone;
+    iterstart_=0;
+
+    writer_.Flush();
+  }
+
+
+  void UpdateParameters(){
+
+    auto pars=psi_.GetParameters();
+
+    //the sampler uses the current parameters, which are changed only after the solution.
+    //Only this thread communicates with the other nodes
+    std::thread sampling;
+    if(nextsweeps_>0){
+      sampling=std::thread([this](){
+        DrawSamples(nextsweeps_,vsampnext_,logvsampnext_);
+      });
+    }
+
+    srnormprev_=srnorm_;
+    ComputeUpdate(pars);
+
+    SendToAll(pars);
+
+    if(sampling.joinable()){
+      sampling.join();
+
+      vsamp_.swap(vsampnext_);
+      logvsamp_.swap(logvsampnext_);
+      nreused_=0;
+      prefetched_=true;
+      nextsweeps_=0;
+    }
+
+    psi_.SetParameters(pars);
+  }
+
+  //Changes the parameters with the stepper, following the gradient or the solution of the SR equations,
+  //and sets srnorm_ to the norm of the update direction
+  virtual void ComputeUpdate(VectorT & pars){
+    if(dosr_){
+      SolveSr();
+    }
+
+    srnorm_=grad_.norm();
+    opt_.Update(grad_,pars);
+  }
+
+  //Solves the SR equations S x = F, where F is half the gradient.
+  //The solution is stored in grad_
+  void SolveSr(){
+    const int nsamp=vsamp_.rows();
+
+    string solver=solver_type_;
+    if(solver=="Auto"){
+      solver=(!streaming_ && nsamp*totalnodes_<npar_)?"SampleSpace":"ParameterSpace";
+    }
+
+    if(solver=="SampleSpace"){
+      SolveSampleSpace();
+    }
+    else{
+      //the right hand side is half the gradient, which is already summed over the nodes
+      const VectorXcd b=grad_/2.;
+
+      if(solver=="Iterative"){
+        SolveIterative(b);
+      }
+      else if(solver=="BlockDiagonal"){
+        SolveBlockDiagonal(b);
+      }
+      else{
+        SolveParameterSpace(b);
+      }
+    }
+  }
+
+  //Solves the SR equations constructing explicitly the S matrix
+  void SolveParameterSpace(const VectorXcd & b){
+    const int nsamp=vsamp_.rows();
+
+    //Explicit construction of the lower triangle of the S matrix
+    MatrixXcd S;
+    if(streaming_){
+      S.swap(Sacc_);
+    }
+    else{
+      S=MatrixXcd::Zero(npar_,npar_);
+      S.selfadjointView<Lower>().rankUpdate(Ok_.adjoint().template cast<complex<double>>());
+    }
+
+    VectorXcd deltaP(npar_);
+
+    if(solve_on_root_){
+      SumLowerOnRoot(S);
+
+      if(mynode_==0){
+        S/=double(nsamp*totalnodes_);
+        deltaP=DenseSolve(S,b);
+      }
+      SendToAll(deltaP);
+    }
+    else{
+      SumLowerOnNodes(S);
+      S/=double(nsamp*totalnodes_);
+
+      deltaP=DenseSolve(S,b);
+    }
+
+    assert(deltaP.size()==grad_.size());
+    grad_=deltaP;
+
+    //since (S+shift) deltaP = b, the norm of deltaP in the metric S+shift is deltaP^H b
+    if(sr_rescale_shift_){
+      complex<double> nor=deltaP.dot(b);
+      grad_/=std::sqrt(nor.real());
+    }
+  }
+
+  //Solves (S+shift) x = b with the dense solver.
+  //If the update is too large, the shift is multiplied by 10 and the equations are solved again,
+  //at the cost of two matrix-vector products with the eigenvectors of S
+  VectorXcd DenseSolve(MatrixXcd & S,const VectorXcd & b){
+    VectorXcd x=dense_solver_.Solve(S,b,sr_diag_shift_);
+
+    //the retries stop if the decomposition is not available
+    double shift=sr_diag_shift_;
+    for(int k=0;k<shift_retries_ && max_update_norm_>0 && x.norm()>max_update_norm_;k++){
+      shift*=10;
+      if(!dense_solver_.Resolve(b,shift,x)){
+        break;
+      }
+    }
+    return x;
+  }
+
+  //Solves the SR equations in the space of samples, using the identity
+  //(A^H A/N + eps)^{-1} A^H e/N = A^H (A A^H/N + eps)^{-1} e/N
+  //where A is the matrix of centered derivatives of all the nodes.
+  //This is convenient when the total number of samples is smaller than the number of parameters
+  void SolveSampleSpace(){
+    const double nsamptot=double(vsamp_.rows()*totalnodes_);
+
+    //number of rows of Ok on each node
+    int myrows=Ok_.rows();
+    vector<int> nrows(totalnodes_);
+    MPI_Allgather(&myrows,1,MPI_INT,nrows.data(),1,MPI_INT,MPI_COMM_WORLD);
+
+    vector<int> offsets(totalnodes_+1,0);
+    for(int r=0;r<totalnodes_;r++){
+      offsets[r+1]=offsets[r]+nrows[r];
+    }
+    const int ntot=offsets[totalnodes_];
+    const int myoffset=offsets[mynode_];
+
+    //Lower triangle of the Gram matrix A A^H,
+    //every node computes its own rows, receiving in turn the derivatives of the other nodes
+    MatrixXcd G=MatrixXcd::Zero(ntot,ntot);
+    MatrixT block;
+
+    for(int r=0;r<totalnodes_;r++){
+      if(r==mynode_){
+        SendToAll(Ok_,r);
+        G.block(myoffset,myoffset,myrows,myrows)=Ok_*Ok_.adjoint();
+      }
+      else{
+        block.resize(nrows[r],npar_);
+        SendToAll(block,r);
+        if(r<mynode_){
+          G.block(myoffset,offsets[r],myrows,nrows[r])=Ok_*block.adjoint();
+        }
+      }
+    }
+    SumLowerOnNodes(G);
+
+    VectorXcd e=VectorXcd::Zero(ntot);
+    e.segment(myoffset,myrows)=elocs_;
+    SumOnNodes(e);
+
+    G/=nsamptot;
+    G.diagonal().array()+=sr_diag_shift_;
+
+    const VectorXcd y=G.ldlt().solve(e);
+
+    grad_=Ok_.adjoint()*y.segment(myoffset,myrows);
+    SumOnNodes(grad_);
+    grad_/=nsamptot;
+
+    if(sr_rescale_shift_){
+      double nor=(Ok_*grad_).squaredNorm();
+      SumOnNodes(nor);
+      nor=nor/nsamptot+sr_diag_shift_*grad_.squaredNorm();
+      grad_/=std::sqrt(nor);
+    }
+  }
+
+  //Partitions the parameters in blocks, using the ones suggested by the machine,
+  //or contiguous blocks of the given size
+  void SetParameterBlocks(int blocksize=0){
+    blocks_.clear();
+
+    if(blocksize<=0){
+      blocks_=psi_.ParameterBlocks();
+      blocksize=64;
+    }
+
+    if(blocks_.empty()){
+      for(int k=0;k<npar_;k+=blocksize){
+        blocks_.push_back(vector<int>());
+        for(int p=k;p<std::min(k+blocksize,npar_);p++){
+          blocks_.back().push_back(p);
+        }
+      }
+    }
+  }
+
+  //Solves the SR equations neglecting the elements of S between different blocks of parameters
+  void SolveBlockDiagonal(const VectorXcd & b){
+    const int nsamp=vsamp_.rows();
+
+    Index packedsize=0;
+    for(const auto & block : blocks_){
+      packedsize+=Index(block.size())*(block.size()+1)/2;
+    }
+
+    //the lower triangles of all the blocks are summed over the nodes with a single reduction
+    VectorXcd packed(packedsize);
+    MatrixXcd Okb;
+    MatrixXcd Sb;
+
+    Index k=0;
+    for(const auto & block : blocks_){
+      const Index nb=block.size();
+
+      Okb.resize(Ok_.rows(),nb);
+      for(int p=0;p<nb;p++){
+        Okb.col(p)=Ok_.col(block[p]).template cast<complex<double>>();
+      }
+
+      Sb=MatrixXcd::Zero(nb,nb);
+      Sb.selfadjointView<Lower>().rankUpdate(Okb.adjoint());
+
+      packed.segment(k,nb*(nb+1)/2)=PackLower(Sb);
+      k+=nb*(nb+1)/2;
+    }
+
+    SumOnNodes(packed);
+    packed/=double(nsamp*totalnodes_);
+
+    VectorXcd deltaP=VectorXcd::Zero(npar_);
+    VectorXcd bb;
+
+    k=0;
+    for(const auto & block : blocks_){
+      const Index nb=block.size();
+
+      Sb.resize(nb,nb);
+      UnpackLower(packed.segment(k,nb*(nb+1)/2),Sb);
+      k+=nb*(nb+1)/2;
+
+      bb.resize(nb);
+      for(int p=0;p<nb;p++){
+        bb(p)=b(block[p]);
+      }
+
+      const VectorXcd x=dense_solver_.Solve(Sb,bb,sr_diag_shift_);
+
+      for(int p=0;p<nb;p++){
+        deltaP(block[p])=x(p);
+      }
+    }
+
+    grad_=deltaP;
+
+    if(sr_rescale_shift_){
+      complex<double> nor=deltaP.dot(b);
+      grad_/=std::sqrt(nor.real());
+    }
+  }
+
+  //Solves the SR equations with the conjugate gradient method, without constructing the S matrix
+  void SolveIterative(const VectorXcd & b){
+    const int nsamp=vsamp_.rows();
+
+    MatrixReplacement S;
+    if(single_precision_){
+      S.attachMatrix(Okf_);
+    }
+    else{
+      S.attachMatrix(Ok_);
+    }
+    S.setShift(sr_diag_shift_);
+    S.setScale(1./double(nsamp*totalnodes_));
+
+    VectorXcd deltaP;
+    if(warm_start_){
+      deltaP=gradprev_;
+    }
+    else{
+      deltaP=VectorXcd::Zero(npar_);
+    }
+
+    if(single_precision_){
+      //the conjugate gradient runs with single precision products,
+      //and its solution is corrected using residuals computed with double precision products.
+      //The residuals still use the single precision derivatives, so this removes
+      //the rounding errors of the products but not the one of storing Ok in single precision
+      MatrixReplacement Sf=S;
+      Sf.setSingleProducts(true);
+
+      const VectorXcd zero=VectorXcd::Zero(npar_);
+      VectorXcd Sx;
+
+      for(int k=0;k<5;k++){
+        Sx=S*deltaP;
+        const VectorXcd r=b-Sx;
+        if(k>0 && r.norm()<=1.0e-3*b.norm()){
+          break;
+        }
+        deltaP+=SolveCg(Sf,r,zero);
+      }
+    }
+    else{
+      deltaP=SolveCg(S,b,deltaP);
+    }
+
+    //the unscaled solution is the starting point for the next iteration
+    gradprev_=deltaP;
+
+    grad_=deltaP;
+    if(sr_rescale_shift_){
+      auto nor=deltaP.dot(S*deltaP);
+      grad_/=std::sqrt(nor.real());
+    }
+  }
+
+  VectorXcd SolveCg(const MatrixReplacement & S,const VectorXcd & b,const VectorXcd & guess){
+    if(use_jacobi_){
+      return SolveCg<JacobiPreconditioner>(S,b,guess);
+    }
+    else{
+      return SolveCg<Eigen::IdentityPreconditioner>(S,b,guess);
+    }
+  }
+
+  template<class Precond> VectorXcd SolveCg(const MatrixReplacement & S,const VectorXcd & b,const VectorXcd & guess){
+    Eigen::ConjugateGradient<MatrixReplacement, Eigen::Lower|Eigen::Upper, Precond> it_solver;
+    // Eigen::GMRES<MatrixReplacement, Eigen::IdentityPreconditioner> it_solver;
+    it_solver.setTolerance(1.0e-3);
+
+    it_solver.compute(S);
+
+    VectorXcd deltaP=it_solver.solveWithGuess(b,guess);
+
+    // if(mynode_==0){
+    //   cerr<<it_solver.iterations()<<"  "<<it_solver.error()<<endl;
+    // }
+    return deltaP;
+  }
+
+  //Adds the quantities specific to the method to the log of an iteration
+  virtual void AddOutput(json & jiter){}
+
+  void PrintOutput(double i){
+    auto Acceptance=sampler_.Acceptance();
+
+    auto jiter=json(obsmanager_);
+    jiter["Iteration"]=i+Iter0_;
+    if(autosweeps_){
+      jiter["SweepsPerSample"]=sweeps_per_sample_;
+    }
+    if(reuse_max_>0 || pipelined_){
+      jiter["EffectiveSamples"]=ess_;
+    }
+    AddOutput(jiter);
+    if(adaptive_){
+      jiter["Nsamples"]=vsamp_.rows()*totalnodes_;
+      jiter["GradientSnr"]=gradsnr_;
+    }
+
+    //observables not measured in this iteration are not written
+    for(int k=0;k<obs_.Size();k++){
+      if(!measure_[k+1] && !dedicated_[k]){
+        jiter.erase(obs_(k).Name());
+      }
+    }
+
+    //exact expectation values have no statistical error
+    if(exact_){
+      jiter["Energy"]=json{{"Mean",exactvals_(0)},{"Sigma",0.}};
+      jiter["EnergyVariance"]=json{{"Mean",exactvals_(1)},{"Sigma",0.}};
+      for(int k=0;k<obs_.Size();k++){
+        if(measure_[k+1] && !dedicated_[k]){
+          jiter[obs_(k).Name()]=json{{"Mean",exactvals_(k+2)},{"Sigma",0.}};
+        }
+      }
+    }
+
+    for(const auto & name : logvectors_){
+      if(name=="Acceptance"){
+        //averaged over the nodes
+        SumOnNodes(Acceptance);
+        Acceptance/=double(totalnodes_);
+        jiter["Acceptance"]=Acceptance;
+      }
+      else if(name=="Gradient" && mynode_==0){
+        jiter["Gradient"]=grad_;
+      }
+      else if(name=="Parameters" && mynode_==0){
+        jiter["Parameters"]=psi_.GetParameters();
+      }
+    }
+
+    if(mynode_==0){
+      writer_.Push([this,jiter](){
+        logwriter_.Write(jiter);
+      });
+    }
+
+    //the parameters are copied, and saved while the next iterations run
+    if(mynode_==0 && freqbackup_>0 &&  std::fmod(i,freqbackup_)<0.5){
+      std::shared_ptr<AbstractMachine<typename Psi::StateType>> snapshot(psi_.Clone());
+      const string filename=filewfname_;
+
+      writer_.Push([snapshot,filename](){
+        snapshot->Save(filename);
+      });
+    }
+  }
+
+
+  void setSrParameters(double diagshift=0.01,bool rescale_shift=false,bool use_iterative=false,
+      string solver="ParameterSpace"){
+    sr_diag_shift_=diagshift;
     sr_rescale_shift_=rescale_shift;
-    use_iterative_=use_iterative;
+    use_iterative_=use_iterative || solver=="Iterative";
+    solver_type_=use_iterative_?string("Iterative"):solver;
     dosr_=true;
   }
 
@@ -433,6 +2013,12 @@ public:
   inline double real_part(double val)const{
     return val;
   }
+  inline void assign_from_complex(const VectorXcd & val,VectorXd & dest)const{
+    dest=val.real();
+  }
+  inline void assign_from_complex(const VectorXcd & val,VectorXcd & dest)const{
+    dest=val;
+  }
   inline double real_part(const std::complex<double> & val)const{
     return val.real();
   }
@@ -0,0 +1,174 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_SR_DENSE_SOLVER_HH
+#define NETKET_SR_DENSE_SOLVER_HH
+
+#include <iostream>
+#include <string>
+#include <complex>
+#include <Eigen/Dense>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Direct solvers for the equations of the stochastic reconfiguration, (S+shift) x = b
+//S is Hermitian and positive semi-definite, and only its lower triangle is referenced
+class SrDenseSolver{
+
+  //QR, LDLT, LLT or Eigen
+  string type_;
+
+  //eigenvalues smaller than cutoff_ times the largest one are discarded
+  double cutoff_;
+
+  //eigen-decomposition of the last matrix, re-used to solve for different shifts
+  SelfAdjointEigenSolver<MatrixXcd> eig_;
+
+  //true if eig_ holds a valid decomposition
+  bool eigok_;
+
+public:
+
+  SrDenseSolver(const string & type="QR",double cutoff=1.0e-10):
+    type_(type),cutoff_(cutoff),eigok_(false){
+
+    if(!IsValid(type_)){
+      cerr<<"# Unknown dense solver "<<type_<<endl;
+      std::abort();
+    }
+  }
+
+  static bool IsValid(const string & type){
+    return type=="QR" || type=="LDLT" || type=="LLT" || type=="Eigen";
+  }
+
+  //Solves (S+shift) x = b
+  //The lower triangle of S is overwritten by the factorization.
+  //If the Cholesky or eigen-decomposition fails, or gives a non-finite solution,
+  //the equations are solved again with QR
+  VectorXcd Solve(MatrixXcd & S,const VectorXcd & b,double shift){
+    assert(S.rows()==b.size());
+
+    if(type_=="Eigen"){
+      eig_.compute(S);
+      eigok_=(eig_.info()==Success);
+
+      VectorXcd x;
+      if(eigok_ && Resolve(b,shift,x)){
+        return x;
+      }
+      eigok_=false;
+
+      cerr<<"# The eigen-decomposition of the S matrix failed, using QR instead"<<endl;
+      S.diagonal().array()+=shift;
+      return SolveQR(S,b);
+    }
+
+    S.diagonal().array()+=shift;
+
+    if(type_=="LDLT" || type_=="LLT"){
+      //the strictly upper triangle and the diagonal keep a copy of S,
+      //which is restored if the factorization fails
+      S.triangularView<StrictlyUpper>()=S.adjoint();
+      const VectorXcd diag=S.diagonal();
+
+      VectorXcd x;
+      bool ok;
+      if(type_=="LDLT"){
+        LDLT<Ref<MatrixXcd>,Lower> ldlt(S);
+        ok=(ldlt.info()==Success && ldlt.isPositive());
+        if(ok){
+          x=ldlt.solve(b);
+        }
+      }
+      else{
+        LLT<Ref<MatrixXcd>,Lower> llt(S);
+        ok=(llt.info()==Success);
+        if(ok){
+          x=llt.solve(b);
+        }
+      }
+
+      if(ok && x.allFinite()){
+        return x;
+      }
+
+      cerr<<"# The "<<type_<<" factorization of the S matrix failed, using QR instead."<<endl;
+      cerr<<"# Consider increasing the diagonal shift"<<endl;
+      S.triangularView<StrictlyLower>()=S.adjoint();
+      S.diagonal()=diag;
+      return SolveQR(S,b);
+    }
+
+    //QR needs the full matrix
+    S.triangularView<StrictlyUpper>()=S.adjoint();
+    return SolveQR(S,b);
+  }
+
+  //Solves (S+shift) x = b using the eigen-decomposition of the last S given to Solve
+  //This is cheap, and can be used to try several values of the shift.
+  //Returns false, leaving x unchanged, if there is no valid decomposition
+  //or if the solution is not finite
+  bool Resolve(const VectorXcd & b,double shift,VectorXcd & x)const{
+    assert(type_=="Eigen");
+
+    if(!eigok_){
+      return false;
+    }
+
+    const auto & lambda=eig_.eigenvalues();
+    const auto & V=eig_.eigenvectors();
+
+    const double lmax=lambda.maxCoeff();
+
+    VectorXcd y=V.adjoint()*b;
+
+    for(int i=0;i<y.size();i++){
+      if(lambda(i)>cutoff_*lmax){
+        y(i)/=(lambda(i)+shift);
+      }
+      else{
+        y(i)=0;
+      }
+    }
+
+    const VectorXcd sol=V*y;
+    if(!sol.allFinite()){
+      return false;
+    }
+    x=sol;
+    return true;
+  }
+
+  const string & Type()const{
+    return type_;
+  }
+
+private:
+
+  //Solves S x = b, where S is the full matrix including the shift
+  static VectorXcd SolveQR(MatrixXcd & S,const VectorXcd & b){
+    FullPivHouseholderQR<Ref<MatrixXcd>> qr(S);
+    qr.setThreshold(1.0e-6);
+    return qr.solve(b);
+  }
+
+};
+
+}
+
+#endif
@@ -71,6 +71,14 @@ public:
     return s_->Reset();
   }
 
+  void SaveState(BinaryWriter & out)const{
+    return s_->SaveState(out);
+  }
+
+  void LoadState(BinaryReader & in){
+    return s_->LoadState(in);
+  }
+
 };
 }
 #endif
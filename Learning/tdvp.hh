@@ -0,0 +1,207 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_TDVP_HH
+#define NETKET_TDVP_HH
+
+#include <iostream>
+#include <string>
+#include <complex>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <Eigen/Dense>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Time-dependent variational principle: the parameters follow the evolution
+//in real or imaginary time, integrated with an adaptive Runge-Kutta method.
+//The time derivatives solve the equations of the stochastic reconfiguration
+template<class Ham,class Psi,class Samp,class Opt> class Tdvp : public Sr<Ham,Psi,Samp,Opt>{
+
+  typedef Sr<Ham,Psi,Samp,Opt> Base;
+  typedef typename Base::VectorT VectorT;
+
+  using Base::psi_;
+  using Base::grad_;
+  using Base::Iter0_;
+  using Base::iterstart_;
+  using Base::freqcheckpoint_;
+  using Base::writer_;
+  using Base::mynode_;
+
+  bool realtime_;
+  double time_;
+  double dt_;
+  double mindt_;
+  double maxdt_;
+  double endtime_;
+
+  //time derivative of the parameters at the current time, re-used by the next step
+  VectorXcd dpdt_;
+
+  //relative and absolute tolerances on the parameters, used by the error control
+  double rtol_;
+  double atol_;
+
+public:
+
+  Tdvp(Ham & ham,Samp & sampler,Opt & opt,const json & pars):
+    Base(ham,sampler,opt,pars,false),time_(0){
+
+    string evolution=FieldOrDefaultVal(pars["Learning"],"TimeEvolution",string("Imaginary"));
+    if(evolution!="Imaginary" && evolution!="Real"){
+      if(mynode_==0){
+        cerr<<"# Unknown TimeEvolution "<<evolution<<endl;
+      }
+      std::abort();
+    }
+    realtime_=(evolution=="Real");
+
+    if(realtime_ && !NumTraits<typename Psi::StateType>::IsComplex){
+      if(mynode_==0){
+        cerr<<"# Real time evolution requires complex parameters"<<endl;
+      }
+      std::abort();
+    }
+
+    dt_=FieldOrDefaultVal(pars["Learning"],"Dt",0.01);
+    mindt_=FieldOrDefaultVal(pars["Learning"],"MinDt",1.0e-6);
+    maxdt_=FieldOrDefaultVal(pars["Learning"],"MaxDt",1.);
+    endtime_=FieldOrDefaultVal(pars["Learning"],"EndTime",std::numeric_limits<double>::max());
+    rtol_=FieldOrDefaultVal(pars["Learning"],"Rtol",1.0e-3);
+    atol_=FieldOrDefaultVal(pars["Learning"],"Atol",1.0e-3);
+
+    this->Start(pars);
+  }
+
+  void PrintMethod(){
+    cout<<"# Integrating the time-dependent variational principle in ";
+    cout<<(realtime_?"real":"imaginary")<<" time, with adaptive steps"<<endl;
+    Base::PrintMethod();
+  }
+
+  void SaveMethodState(BinaryWriter & shared){
+    shared.Write(time_);
+    shared.Write(dt_);
+    shared.Write(dpdt_);
+  }
+
+  void LoadMethodState(BinaryReader & shared){
+    shared.Read(time_);
+    shared.Read(dt_);
+    shared.Read(dpdt_);
+  }
+
+  void AddOutput(json & jiter){
+    jiter["Time"]=time_;
+    jiter["TimeStep"]=dt_;
+  }
+
+  //Integrates the equations of the time-dependent variational principle,
+  //S dp/dt = -F in imaginary time and S dp/dt = -i F in real time,
+  //with the Runge-Kutta method of Bogacki and Shampine, of order 3,
+  //whose embedded estimate of order 2 controls the time step.
+  //At most niter steps are done, until the time reaches endtime_.
+  //The energy and the observables are logged at the beginning and after each accepted step.
+  //Checkpoints are written after accepted steps, and store the index of the next logged step
+  void Run(double nsweeps,double niter){
+    VectorXcd p0=psi_.GetParameters().template cast<complex<double>>();
+    VectorXcd & k1=dpdt_;
+
+    double step=0;
+    if(iterstart_>0){
+      //the derivative at the restored parameters was computed before the checkpoint
+      step=iterstart_-1;
+    }
+    else{
+      this->ScheduleMeasurements(step+Iter0_);
+      k1=TimeDerivative(p0,nsweeps);
+      this->MeasureDedicated();
+      this->PrintOutput(step);
+    }
+
+    while(step<niter && time_<endtime_){
+      const double h=std::min(dt_,endtime_-time_);
+
+      this->ScheduleMeasurements(step+1+Iter0_);
+
+      const VectorXcd k2=TimeDerivative(p0+(0.5*h)*k1,nsweeps);
+      const VectorXcd k3=TimeDerivative(p0+(0.75*h)*k2,nsweeps);
+      const VectorXcd p1=p0+h*((2./9.)*k1+(1./3.)*k2+(4./9.)*k3);
+
+      //the derivative at the end of the step is used by the next step, if accepted
+      const VectorXcd k4=TimeDerivative(p1,nsweeps);
+      const VectorXcd err=h*((-5./72.)*k1+(1./12.)*k2+(1./9.)*k3-(1./8.)*k4);
+
+      const VectorXd scale=atol_+rtol_*p1.cwiseAbs().array().max(p0.cwiseAbs().array());
+      const double errnorm=std::sqrt((err.cwiseAbs().array()/scale.array()).square().mean());
+
+      const bool accept=(errnorm<=1 || h<=mindt_);
+
+      double factor=(errnorm>0)?0.9*std::pow(errnorm,-1./3.):5.;
+      factor=std::min(std::max(factor,0.2),5.);
+      dt_=std::min(std::max(h*factor,mindt_),maxdt_);
+
+      if(accept){
+        time_+=h;
+        p0=p1;
+        k1=k4;
+        step++;
+        this->MeasureDedicated();
+        this->PrintOutput(step);
+
+        if(freqcheckpoint_>0 && std::fmod(step,freqcheckpoint_)<0.5){
+          this->SaveCheckpoint(step+1);
+        }
+      }
+    }
+
+    VectorT pars;
+    this->assign_from_complex(p0,pars);
+    psi_.SetParameters(pars);
+
+    Iter0_+=step;
+    iterstart_=0;
+
+    writer_.Flush();
+  }
+
+  //Computes dp/dt at the given parameters, sampling the wave-function
+  VectorXcd TimeDerivative(const VectorXcd & p,double nsweeps){
+    VectorT pars;
+    this->assign_from_complex(p,pars);
+    psi_.SetParameters(pars);
+
+    this->Sample(nsweeps);
+    this->Gradient();
+    this->SolveSr();
+
+    VectorXcd deriv=-grad_;
+    if(realtime_){
+      deriv*=complex<double>(0,1);
+    }
+
+    //all the nodes follow the same trajectory
+    SendToAll(deriv);
+    return deriv;
+  }
+};
+
+}
+
+#endif
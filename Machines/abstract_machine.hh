@@ -54,6 +54,17 @@ public:
   */
   virtual void SetParameters(const VectorType & pars)=0;
 
+  /**
+  Member function returning a partition of the parameters into blocks
+  of strongly coupled parameters, used by block-diagonal approximations of the S matrix.
+  The default implementation returns no blocks.
+  @return A vector of blocks, each containing the indices of its parameters,
+  in the same order used by GetParameters.
+  */
+  virtual vector<vector<int>> ParameterBlocks()const{
+    return vector<vector<int>>();
+  }
+
 
   /**
   Member function providing a random initialization of the parameters.
@@ -150,6 +161,33 @@ public:
 
 
 
+  /**
+  Member function computing the difference between the logarithm of the wave-function
+  computed at different values of a single visible unit.
+  This version uses the look-up tables to speed-up the calculation.
+  The default implementation calls LogValDiff once for each local value,
+  machines can override it to evaluate all the alternatives in a single pass.
+  @param v a constant reference to the current visible configuration.
+  @param site the index of the visible unit to be changed.
+  @param localstates a constant reference to a vector containing the values to be tried for the unit.
+  @param lt a constant eference to the look-up table.
+  @return A vector containing, for each k, log(Psi(v')) - log(Psi(v)), where v'(site)=localstates(k)
+  */
+  virtual VectorType LogValDiffLocal(const VectorXd & v,int site,
+      const vector<double> & localstates,const LookupType & lt){
+
+    VectorType logvaldiffs(localstates.size());
+
+    vector<int> tochange(1,site);
+    vector<double> newconf(1);
+
+    for(std::size_t k=0;k<localstates.size();k++){
+      newconf[0]=localstates[k];
+      logvaldiffs(k)=LogValDiff(v,tochange,newconf,lt);
+    }
+    return logvaldiffs;
+  }
+
   /**
   Member function computing the derivative of the logarithm of the wave function for a given visible vector.
   @param v a constant reference to a visible configuration.
@@ -160,6 +198,14 @@ public:
   virtual void to_json(json &j)const=0;
   virtual void from_json(const json&j)=0;
 
+  /**
+  Member function returning a copy of the machine, with the current set of parameters.
+  The copy is not affected by later changes of the parameters,
+  and can be used for example to save them in the background.
+  @return A pointer to the new Machine, which is owned by the caller.
+  */
+  virtual AbstractMachine<T> * Clone()const=0;
+
   void Save(std::string filename)const{
     ofstream filewf(filename);
 
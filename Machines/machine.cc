@@ -100,6 +100,10 @@ public:
     return m_->Npar();
   }
 
+  vector<vector<int>> ParameterBlocks()const{
+    return m_->ParameterBlocks();
+  }
+
   int Nvisible()const{
     return m_->Nvisible();
   }
@@ -166,6 +170,14 @@ public:
     return m_->LogValDiff(v,toflip,newconf,lt);
   }
 
+  //Differences between logarithms of values, for all the given values of a single visible unit
+  //Version using pre-computed look-up tables for efficiency
+  VectorType LogValDiffLocal(const VectorXd & v,int site,
+      const vector<double> & localstates,const LookupType & lt){
+
+    return m_->LogValDiffLocal(v,site,localstates,lt);
+  }
+
   void InitRandomPars(int seed,double sigma){
     return m_->InitRandomPars(seed,sigma);
   }
@@ -185,6 +197,10 @@ public:
   void from_json(const json&j){
     m_->from_json(j);
   }
+
+  AbstractMachine<T> * Clone()const{
+    return m_->Clone();
+  }
 };
 }
 #endif
@@ -169,6 +169,40 @@ public:
     return npar_;
   }
 
+  //Blocks of parameters: the visible biases, the hidden biases,
+  //and the weights connected to each hidden unit
+  vector<vector<int>> ParameterBlocks()const{
+    vector<vector<int>> blocks;
+
+    int k=0;
+
+    if(usea_){
+      blocks.push_back(vector<int>());
+      for(int i=0;i<nv_*ls_;i++){
+        blocks.back().push_back(k);
+        k++;
+      }
+    }
+
+    if(useb_){
+      blocks.push_back(vector<int>());
+      for(int p=0;p<nh_;p++){
+        blocks.back().push_back(k);
+        k++;
+      }
+    }
+
+    //weights are stored row by row
+    for(int j=0;j<nh_;j++){
+      blocks.push_back(vector<int>());
+      for(int i=0;i<nv_*ls_;i++){
+        blocks.back().push_back(k+i*nh_+j);
+      }
+    }
+
+    return blocks;
+  }
+
   void InitRandomPars(int seed,double sigma){
 
     VectorType par(npar_);
@@ -377,6 +411,42 @@ public:
     return logvaldiff;
   }
 
+  //Differences between logarithms of values, for all the given values of a single visible unit
+  //The look-up table is used once for all the alternatives,
+  //and a single row of W is gathered for each of them
+  VectorType LogValDiffLocal(const VectorXd & v,int site,
+    const vector<double> & localstates,const LookupType & lt){
+
+    const int nst=localstates.size();
+    VectorType logvaldiffs(nst);
+
+    RbmSpin<T>::lncosh(lt.V(0),lnthetas_);
+    const T logtsum=lnthetas_.sum();
+
+    const int oldtilde=confindex_[v[site]];
+
+    //theta pseudo-angles with the contribution of the current local state removed
+    thetas_=lt.V(0);
+    thetas_-=W_.row(ls_*site+oldtilde);
+
+    for(int k=0;k<nst;k++){
+      const int newtilde=confindex_[localstates[k]];
+
+      if(newtilde==oldtilde){
+        logvaldiffs(k)=0.;
+      }
+      else{
+        thetasnew_=thetas_;
+        thetasnew_+=W_.row(ls_*site+newtilde);
+
+        RbmSpin<T>::lncosh(thetasnew_,lnthetasnew_);
+        logvaldiffs(k)=a_(ls_*site+newtilde)-a_(ls_*site+oldtilde);
+        logvaldiffs(k)+=lnthetasnew_.sum()-logtsum;
+      }
+    }
+    return logvaldiffs;
+  }
+
   //Computhes the values of the theta pseudo-angles
   inline void ComputeTheta(const VectorXd &v,VectorType & theta){
     ComputeVtilde(v,vtilde_);
@@ -408,6 +478,10 @@ public:
     return hilbert_;
   }
 
+  AbstractMachine<T> * Clone()const{
+    return new RbmMultival<T>(*this);
+  }
+
   void to_json(json &j)const{
     j["Machine"]["Name"]="RbmMultival";
     j["Machine"]["Nvisible"]=nv_;
@@ -131,6 +131,40 @@ public:
     return npar_;
   }
 
+  //Blocks of parameters: the visible biases, the hidden biases,
+  //and the weights connected to each hidden unit
+  vector<vector<int>> ParameterBlocks()const{
+    vector<vector<int>> blocks;
+
+    int k=0;
+
+    if(usea_){
+      blocks.push_back(vector<int>());
+      for(int i=0;i<nv_;i++){
+        blocks.back().push_back(k);
+        k++;
+      }
+    }
+
+    if(useb_){
+      blocks.push_back(vector<int>());
+      for(int p=0;p<nh_;p++){
+        blocks.back().push_back(k);
+        k++;
+      }
+    }
+
+    //weights are stored row by row
+    for(int j=0;j<nh_;j++){
+      blocks.push_back(vector<int>());
+      for(int i=0;i<nv_;i++){
+        blocks.back().push_back(k+i*nh_+j);
+      }
+    }
+
+    return blocks;
+  }
+
   void InitRandomPars(int seed,double sigma){
 
     VectorType par(npar_);
@@ -327,6 +361,33 @@ public:
     return logvaldiff;
   }
 
+  //Differences between logarithms of values, for all the given values of a single visible unit
+  //The look-up table is used once for all the alternatives
+  VectorType LogValDiffLocal(const VectorXd & v,int site,
+    const vector<double> & localstates,const LookupType & lt){
+
+    const int nst=localstates.size();
+    VectorType logvaldiffs(nst);
+
+    RbmSpin::lncosh(lt.V(0),lnthetas_);
+    const T logtsum=lnthetas_.sum();
+
+    for(int k=0;k<nst;k++){
+      const double dv=localstates[k]-v(site);
+
+      if(dv==0){
+        logvaldiffs(k)=0.;
+      }
+      else{
+        thetasnew_=lt.V(0)+W_.row(site).transpose()*dv;
+
+        RbmSpin::lncosh(thetasnew_,lnthetasnew_);
+        logvaldiffs(k)=a_(site)*dv+lnthetasnew_.sum()-logtsum;
+      }
+    }
+    return logvaldiffs;
+  }
+
   static void RandomGaussian(Matrix<double,Dynamic,1> & par,int seed,double sigma){
     std::default_random_engine generator(seed);
     std::normal_distribution<double> distribution(0,sigma);
@@ -383,6 +444,10 @@ public:
     return hilbert_;
   }
 
+  AbstractMachine<T> * Clone()const{
+    return new RbmSpin<T>(*this);
+  }
+
   void to_json(json &j)const{
     j["Machine"]["Name"]="RbmSpin";
     j["Machine"]["Nvisible"]=nv_;
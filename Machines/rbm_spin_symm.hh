@@ -206,6 +206,37 @@ public:
     return npar_;
   }
 
+  //Blocks of parameters: the visible biases, the hidden biases,
+  //and the weights connected to each symmetric set of hidden units
+  vector<vector<int>> ParameterBlocks()const{
+    vector<vector<int>> blocks;
+
+    int k=0;
+
+    if(usea_){
+      blocks.push_back({k});
+      k++;
+    }
+
+    if(useb_){
+      blocks.push_back(vector<int>());
+      for(int p=0;p<alpha_;p++){
+        blocks.back().push_back(k);
+        k++;
+      }
+    }
+
+    //weights are stored row by row
+    for(int j=0;j<alpha_;j++){
+      blocks.push_back(vector<int>());
+      for(int i=0;i<nv_;i++){
+        blocks.back().push_back(k+i*alpha_+j);
+      }
+    }
+
+    return blocks;
+  }
+
   void InitRandomPars(int seed,double sigma){
 
     VectorType par(npar_);
@@ -436,6 +467,10 @@ public:
     return hilbert_;
   }
 
+  AbstractMachine<T> * Clone()const{
+    return new RbmSpinSymm<T>(*this);
+  }
+
   void to_json(json &j)const{
     j["Machine"]["Name"]="RbmSpinSymm";
     j["Machine"]["Nvisible"]=nv_;
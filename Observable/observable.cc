@@ -24,6 +24,11 @@ class Observable:public AbstractObservable{
 
   AbstractObservable *o_;
 
+  //the observable is measured every measure_every_ iterations of the optimization,
+  //on nsamples_ dedicated samples, or on the samples of the optimization if nsamples_ is zero
+  double measure_every_;
+  double nsamples_;
+
 public:
 
   using MatType=LocalOperator::MatType;
@@ -49,6 +54,8 @@ public:
 
       o_=new CustomObservable(hilbert,jop,sites,name);
 
+      measure_every_=FieldOrDefaultVal(obspars,"MeasureEvery",1.);
+      nsamples_=FieldOrDefaultVal(obspars,"Nsamples",0.);
   }
 
   void FindConn(const VectorXd & v,
@@ -66,6 +73,14 @@ public:
   const std::string Name()const{
     return o_->Name();
   }
+
+  double MeasureEvery()const{
+    return measure_every_;
+  }
+
+  double Nsamples()const{
+    return nsamples_;
+  }
 };
 }
 #endif
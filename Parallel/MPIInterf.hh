@@ -21,6 +21,7 @@
 #include <complex>
 #include <Eigen/Dense>
 #include <cassert>
+#include <algorithm>
 
 namespace netket{
 
@@ -55,6 +56,39 @@ void SendToAll(VectorXd & value,int root=0,const MPI_Comm comm=MPI_COMM_WORLD){
 void SendToAll(VectorXcd & value,int root=0,const MPI_Comm comm=MPI_COMM_WORLD){
   MPI_Bcast(value.data(),value.size(),MPI_DOUBLE_COMPLEX,root,comm);
 }
+void SendToAll(MatrixXd & value,int root=0,const MPI_Comm comm=MPI_COMM_WORLD){
+  MPI_Bcast(value.data(),value.size(),MPI_DOUBLE,root,comm);
+}
+void SendToAll(MatrixXcd & value,int root=0,const MPI_Comm comm=MPI_COMM_WORLD){
+  MPI_Bcast(value.data(),value.size(),MPI_DOUBLE_COMPLEX,root,comm);
+}
+
+//MPI counts are int, so larger buffers are reduced in chunks of this size
+const Index mpi_max_count=Index(1)<<30;
+
+//Sums in place a buffer of complex numbers of any size over the nodes
+inline void SumInChunks(complex<double> * value,Index size,const MPI_Comm comm=MPI_COMM_WORLD){
+  for(Index k=0;k<size;k+=mpi_max_count){
+    const int count=int(std::min(mpi_max_count,size-k));
+    MPI_Allreduce(MPI_IN_PLACE,value+k,count,MPI_DOUBLE_COMPLEX,MPI_SUM,comm);
+  }
+}
+
+//Same as SumInChunks, but the result is only available on the root node
+inline void SumInChunksOnRoot(complex<double> * value,Index size,int root=0,const MPI_Comm comm=MPI_COMM_WORLD){
+  int mynode;
+  MPI_Comm_rank(comm,&mynode);
+
+  for(Index k=0;k<size;k+=mpi_max_count){
+    const int count=int(std::min(mpi_max_count,size-k));
+    if(mynode==root){
+      MPI_Reduce(MPI_IN_PLACE,value+k,count,MPI_DOUBLE_COMPLEX,MPI_SUM,root,comm);
+    }
+    else{
+      MPI_Reduce(value+k,nullptr,count,MPI_DOUBLE_COMPLEX,MPI_SUM,root,comm);
+    }
+  }
+}
 
 //Accumulates the sum of val collected from all nodes and the sum is distributed back to all processors
 inline void SumOnNodes(double & val,double & sum,const MPI_Comm comm=MPI_COMM_WORLD){
@@ -102,7 +136,7 @@ inline void SumOnNodes(MatrixXd & value,const MPI_Comm comm=MPI_COMM_WORLD){
 }
 
 inline void SumOnNodes(MatrixXcd & value,const MPI_Comm comm=MPI_COMM_WORLD){
-  MPI_Allreduce(MPI_IN_PLACE,value.data(),value.size(),MPI_DOUBLE_COMPLEX,MPI_SUM,comm);
+  SumInChunks(value.data(),value.size(),comm);
 }
 
 inline void SumOnNodes(double & value,const MPI_Comm comm=MPI_COMM_WORLD){
@@ -130,7 +164,7 @@ inline void SumOnNodes(complex<double> & value,const MPI_Comm comm=MPI_COMM_WORL
 }
 
 inline void SumOnNodes(VectorXcd & value,const MPI_Comm comm=MPI_COMM_WORLD){
-  MPI_Allreduce(MPI_IN_PLACE,value.data(),value.size(),MPI_DOUBLE_COMPLEX,MPI_SUM,comm);
+  SumInChunks(value.data(),value.size(),comm);
 }
 
 inline void SumOnNodes(VectorXcd & val,VectorXcd & sum,const MPI_Comm comm=MPI_COMM_WORLD){
@@ -138,6 +172,53 @@ inline void SumOnNodes(VectorXcd & val,VectorXcd & sum,const MPI_Comm comm=MPI_C
   MPI_Allreduce(val.data(),sum.data(),val.size(),MPI_DOUBLE_COMPLEX,MPI_SUM,comm);
 }
 
+//Packs the lower triangle of a square matrix, column by column
+inline VectorXcd PackLower(const MatrixXcd & value){
+  const Index n=value.rows();
+  VectorXcd packed(n*(n+1)/2);
+
+  Index k=0;
+  for(Index j=0;j<n;j++){
+    packed.segment(k,n-j)=value.col(j).tail(n-j);
+    k+=n-j;
+  }
+  return packed;
+}
+
+inline void UnpackLower(const VectorXcd & packed,MatrixXcd & value){
+  const Index n=value.rows();
+
+  Index k=0;
+  for(Index j=0;j<n;j++){
+    value.col(j).tail(n-j)=packed.segment(k,n-j);
+    k+=n-j;
+  }
+}
+
+//Sums the lower triangle of a Hermitian matrix over the nodes
+//only the n(n+1)/2 independent elements are communicated, in chunks if needed
+inline void SumLowerOnNodes(MatrixXcd & value,const MPI_Comm comm=MPI_COMM_WORLD){
+  VectorXcd packed=PackLower(value);
+  SumInChunks(packed.data(),packed.size(),comm);
+  UnpackLower(packed,value);
+}
+
+//Same as SumLowerOnNodes, but the result is only available on the root node
+inline void SumLowerOnRoot(MatrixXcd & value,int root=0,const MPI_Comm comm=MPI_COMM_WORLD){
+  int mynode;
+  MPI_Comm_rank(comm,&mynode);
+
+  VectorXcd packed=PackLower(value);
+  SumInChunksOnRoot(packed.data(),packed.size(),root,comm);
+  if(mynode==root){
+    UnpackLower(packed,value);
+  }
+}
+
+inline void MaxOnNodes(double & value,const MPI_Comm comm=MPI_COMM_WORLD){
+  MPI_Allreduce(MPI_IN_PLACE,&value,1,MPI_DOUBLE,MPI_MAX,comm);
+}
+
 }
 
 #endif
@@ -16,5 +16,6 @@
 #define NETKET_PARALLEL_HH
 
 #include "MPIInterf.hh"
+#include "parallel_for.hh"
 
 #endif
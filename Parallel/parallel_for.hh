@@ -0,0 +1,78 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NETKET_PARALLELFOR_HH
+#define NETKET_PARALLELFOR_HH
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <mpi.h>
+
+namespace netket{
+
+//Number of processes running on the same node as this one, which share its cores.
+//The first call is collective over MPI_COMM_WORLD
+inline int NodeProcesses(){
+  static int nprocs=0;
+
+  if(nprocs==0){
+    int initialized;
+    MPI_Initialized(&initialized);
+    if(!initialized){
+      return 1;
+    }
+
+    MPI_Comm shared;
+    MPI_Comm_split_type(MPI_COMM_WORLD,MPI_COMM_TYPE_SHARED,0,MPI_INFO_NULL,&shared);
+    MPI_Comm_size(shared,&nprocs);
+    MPI_Comm_free(&shared);
+  }
+  return nprocs;
+}
+
+//Number of threads used by default by each process:
+//the cores reported by the system are divided among the processes of the node,
+//so that running several processes per node does not oversubscribe it
+inline int DefaultNthreads(){
+  const int ncores=std::max(1u,std::thread::hardware_concurrency());
+  return std::max(1,ncores/NodeProcesses());
+}
+
+//Calls func(begin,end,thread) on nthreads contiguous ranges covering [0,n),
+//each in a separate thread. Returns when all the threads are done
+template<class Func> void ParallelFor(int nthreads,long n,Func func){
+  nthreads=int(std::max(1L,std::min(long(nthreads),n)));
+
+  if(nthreads==1){
+    func(0L,n,0);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  const long chunk=(n+nthreads-1)/nthreads;
+
+  for(int t=0;t<nthreads;t++){
+    const long begin=std::min(n,t*chunk);
+    const long end=std::min(n,begin+chunk);
+    threads.emplace_back(func,begin,end,t);
+  }
+  for(auto & thread : threads){
+    thread.join();
+  }
+}
+
+}
+
+#endif
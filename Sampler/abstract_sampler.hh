@@ -25,8 +25,11 @@ public:
   virtual void Sweep()=0;
   virtual VectorXd Visible()=0;
   virtual void SetVisible(const VectorXd & v)=0;
+  virtual typename WfType::StateType LogVal()=0;
   virtual WfType & Psi()=0;
   virtual VectorXd Acceptance()const=0;
+  virtual void SaveState(BinaryWriter & out)const=0;
+  virtual void LoadState(BinaryReader & in)=0;
 
 };
 
@@ -0,0 +1,250 @@
+// Copyright 2018 The Simons Foundation, Inc. - All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef NETKET_HEATBATHLOCAL_HH
+#define NETKET_HEATBATHLOCAL_HH
+
+#include <iostream>
+#include <Eigen/Dense>
+#include <random>
+#include <mpi.h>
+#include <limits>
+
+namespace netket{
+
+using namespace std;
+using namespace Eigen;
+
+//Heat-bath sampling of local states
+//the new state of a random site is drawn directly from its conditional distribution
+template<class WfType> class HeatBathLocal: public AbstractSampler<WfType>{
+
+  WfType & psi_;
+
+  const Hilbert & hilbert_;
+
+  //number of visible units
+  const int nv_;
+
+  netket::default_random_engine rgen_;
+
+  //states of visible units
+  VectorXd v_;
+
+  VectorXd accept_;
+  VectorXd moves_;
+
+  int mynode_;
+  int totalnodes_;
+
+  //Look-up tables
+  typename WfType::LookupType lt_;
+
+  //current value of the logarithm of the wave-function
+  typename WfType::StateType logval_;
+
+  //number of sweeps after which logval_ is recomputed from scratch
+  int resync_every_;
+  int nsweeps_;
+
+  int nstates_;
+  vector<double> localstates_;
+
+  //conditional probabilities of the local states
+  vector<double> probs_;
+
+public:
+
+  HeatBathLocal(WfType & psi):
+       psi_(psi),hilbert_(psi.GetHilbert()),nv_(hilbert_.Size()){
+    Init();
+  }
+
+  //Json constructor
+  HeatBathLocal(Graph & graph,WfType & psi,const json & pars):
+    psi_(psi),hilbert_(psi.GetHilbert()),nv_(hilbert_.Size()){
+    Init();
+  }
+
+  void Init(){
+    v_.resize(nv_);
+
+    MPI_Comm_size(MPI_COMM_WORLD, &totalnodes_);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mynode_);
+
+    if(!hilbert_.IsDiscrete()){
+      if(mynode_==0){
+        cerr<<"# Heat-bath sampler works only for discrete Hilbert spaces"<<endl;
+      }
+      std::abort();
+    }
+
+    accept_.resize(1);
+    moves_.resize(1);
+
+    nstates_=hilbert_.LocalSize();
+    localstates_=hilbert_.LocalStates();
+    probs_.resize(nstates_);
+
+    resync_every_=100;
+
+    Seed();
+
+    Reset(true);
+
+    if(mynode_==0){
+      cout<<"# Heat-bath local sampler is ready "<<endl;
+    }
+  }
+
+  void Seed(int baseseed=0){
+    std::random_device rd;
+    vector<int> seeds(totalnodes_);
+
+    if(mynode_==0){
+      for(int i=0;i<totalnodes_;i++){
+        seeds[i]=rd()+baseseed;
+      }
+    }
+
+    SendToAll(seeds);
+
+    rgen_.seed(seeds[mynode_]);
+  }
+
+
+  void Reset(bool initrandom=false){
+    if(initrandom){
+      hilbert_.RandomVals(v_,rgen_);
+    }
+
+    Resync();
+
+    accept_=VectorXd::Zero(1);
+    moves_=VectorXd::Zero(1);
+  }
+
+  void Sweep(){
+
+    vector<int> tochange(1);
+    vector<double> newconf(1);
+
+    std::uniform_real_distribution<double> distu;
+    std::uniform_int_distribution<int> distrs(0,nv_-1);
+
+    for(int i=0;i<nv_;i++){
+
+      //picking a random site to be changed
+      int si=distrs(rgen_);
+      assert(si<nv_);
+      tochange[0]=si;
+
+      //log-ratios for all the local states of the site, in a single pass
+      const auto lvds=psi_.LogValDiffLocal(v_,si,localstates_,lt_);
+
+      double maxlog=-std::numeric_limits<double>::infinity();
+      for(int k=0;k<nstates_;k++){
+        maxlog=std::max(maxlog,2.*std::real(lvds(k)));
+      }
+
+      double norm=0;
+      for(int k=0;k<nstates_;k++){
+        probs_[k]=std::exp(2.*std::real(lvds(k))-maxlog);
+        norm+=probs_[k];
+      }
+
+      //sampling the new state from the conditional distribution
+      double r=distu(rgen_)*norm;
+      int newstate=0;
+      while(newstate<nstates_-1 && r>=probs_[newstate]){
+        r-=probs_[newstate];
+        newstate++;
+      }
+      newconf[0]=localstates_[newstate];
+
+      if(std::abs(newconf[0]-v_(si))>std::numeric_limits<double>::epsilon()){
+        accept_[0]+=1;
+        psi_.UpdateLookup(v_,tochange,newconf,lt_);
+        hilbert_.UpdateConf(v_,tochange,newconf);
+        logval_+=lvds(newstate);
+      }
+      moves_[0]+=1;
+    }
+
+    nsweeps_++;
+    if(nsweeps_>=resync_every_){
+      Resync();
+    }
+  }
+
+  //Recomputes look-up tables and the logarithm of the wave-function from scratch
+  //this avoids the accumulation of round-off errors in the incremental updates
+  void Resync(){
+    psi_.InitLookup(v_,lt_);
+    logval_=psi_.LogVal(v_,lt_);
+    nsweeps_=0;
+  }
+
+  VectorXd Visible(){
+    return v_;
+  }
+
+  void SetVisible(const VectorXd & v){
+    v_=v;
+    Resync();
+  }
+
+  typename WfType::StateType LogVal(){
+    return logval_;
+  }
+
+  WfType & Psi(){
+    return psi_;
+  }
+
+  const Hilbert & HilbSpace()const{
+    return hilbert_;
+  }
+
+  VectorXd Acceptance()const{
+    VectorXd acc=accept_;
+    for(int i=0;i<1;i++){
+      acc(i)/=moves_(i);
+    }
+    return acc;
+  }
+
+  //the look-up tables and the value of the wave-function are recomputed when the state is loaded
+  void SaveState(BinaryWriter & out)const{
+    out.Write(rgen_);
+    out.Write(v_);
+    out.Write(accept_);
+    out.Write(moves_);
+  }
+
+  void LoadState(BinaryReader & in){
+    in.Read(rgen_);
+    in.Read(v_);
+    in.Read(accept_);
+    in.Read(moves_);
+    Resync();
+  }
+
+};
+
+
+}
+
+#endif
@@ -52,6 +52,13 @@ template<class WfType> class MetropolisExchange: public AbstractSampler<WfType>{
   //Look-up tables
   typename WfType::LookupType lt_;
 
+  //current value of the logarithm of the wave-function
+  typename WfType::StateType logval_;
+
+  //number of sweeps after which logval_ is recomputed from scratch
+  int resync_every_;
+  int nsweeps_;
+
 public:
 
   template<class G> MetropolisExchange(G & graph,WfType & psi,int dmax=1):
@@ -80,6 +87,8 @@ public:
 
     GenerateClusters(graph,dmax);
 
+    resync_every_=100;
+
     Seed();
 
     Reset(true);
@@ -127,7 +136,7 @@ public:
       }
     }
 
-    psi_.InitLookup(v_,lt_);
+    Resync();
 
     accept_=VectorXd::Zero(1);
     moves_=VectorXd::Zero(1);
@@ -156,26 +165,45 @@ public:
         newconf[0]=v_(sj);
         newconf[1]=v_(si);
 
-        double ratio=std::norm(std::exp(psi_.LogValDiff(v_,tochange,newconf,lt_)));
+        const auto lvd=psi_.LogValDiff(v_,tochange,newconf,lt_);
+        double ratio=std::norm(std::exp(lvd));
 
         if(ratio>distu(rgen_)){
           accept_[0]+=1;
           psi_.UpdateLookup(v_,tochange,newconf,lt_);
           hilbert_.UpdateConf(v_,tochange,newconf);
+          logval_+=lvd;
         }
       }
       moves_[0]+=1;
     }
 
+    nsweeps_++;
+    if(nsweeps_>=resync_every_){
+      Resync();
+    }
   }
 
 
+  //Recomputes look-up tables and the logarithm of the wave-function from scratch
+  //this avoids the accumulation of round-off errors in the incremental updates
+  void Resync(){
+    psi_.InitLookup(v_,lt_);
+    logval_=psi_.LogVal(v_,lt_);
+    nsweeps_=0;
+  }
+
   VectorXd Visible(){
     return v_;
   }
 
   void SetVisible(const VectorXd & v){
     v_=v;
+    Resync();
+  }
+
+  typename WfType::StateType LogVal(){
+    return logval_;
   }
 
 
@@ -196,6 +224,22 @@ public:
     return acc;
   }
 
+  //the look-up tables and the value of the wave-function are recomputed when the state is loaded
+  void SaveState(BinaryWriter & out)const{
+    out.Write(rgen_);
+    out.Write(v_);
+    out.Write(accept_);
+    out.Write(moves_);
+  }
+
+  void LoadState(BinaryReader & in){
+    in.Read(rgen_);
+    in.Read(v_);
+    in.Read(accept_);
+    in.Read(moves_);
+    Resync();
+  }
+
 };
 
 
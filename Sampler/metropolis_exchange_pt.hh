@@ -53,6 +53,13 @@ template<class WfType> class MetropolisExchangePt: public AbstractSampler<WfType
   //Look-up tables
   std::vector<typename WfType::LookupType> lt_;
 
+  //current values of the logarithm of the wave-function, for each replica
+  std::vector<typename WfType::StateType> logval_;
+
+  //number of sweeps after which logval_ is recomputed from scratch
+  int resync_every_;
+  int nsweeps_;
+
   bool do_sum_constraint_;
   int sum_constraint_;
 
@@ -92,12 +99,15 @@ public:
     }
 
     lt_.resize(nrep_);
+    logval_.resize(nrep_);
 
     accept_.resize(2*nrep_);
     moves_.resize(2*nrep_);
 
     GenerateClusters(graph,dmax);
 
+    resync_every_=100;
+
     Seed();
 
     Reset(true);
@@ -146,9 +156,7 @@ public:
       }
     }
 
-    for(int i=0;i<nrep_;i++){
-      psi_.InitLookup(v_[i],lt_[i]);
-    }
+    Resync();
 
     accept_=VectorXd::Zero(2*nrep_);
     moves_=VectorXd::Zero(2*nrep_);
@@ -178,12 +186,14 @@ public:
         newconf[0]=v_[rep](sj);
         newconf[1]=v_[rep](si);
 
-        double ratio=std::norm(std::exp(beta_[rep]*psi_.LogValDiff(v_[rep],tochange,newconf,lt_[rep])));
+        const auto lvd=psi_.LogValDiff(v_[rep],tochange,newconf,lt_[rep]);
+        double ratio=std::norm(std::exp(beta_[rep]*lvd));
 
         if(ratio>distu(rgen_)){
           accept_(rep)+=1;
           psi_.UpdateLookup(v_[rep],tochange,newconf,lt_[rep]);
           hilbert_.UpdateConf(v_[rep],tochange,newconf);
+          logval_[rep]+=lvd;
         }
       }
 
@@ -222,12 +232,16 @@ public:
       moves_(nrep_+r-1)+=1;
     }
 
+    nsweeps_++;
+    if(nsweeps_>=resync_every_){
+      Resync();
+    }
   }
 
   //computes the probability to exchange two replicas
   double ExchangeProb(int r1,int r2){
-    const double lf1=2*realpart(psi_.LogVal(v_[r1],lt_[r1]));
-    const double lf2=2*realpart(psi_.LogVal(v_[r2],lt_[r2]));
+    const double lf1=2*realpart(logval_[r1]);
+    const double lf2=2*realpart(logval_[r2]);
 
     return std::exp((beta_[r1]-beta_[r2])*(lf2-lf1));
   }
@@ -235,6 +249,17 @@ public:
   void Exchange(int r1,int r2){
     std::swap(v_[r1],v_[r2]);
     std::swap(lt_[r1],lt_[r2]);
+    std::swap(logval_[r1],logval_[r2]);
+  }
+
+  //Recomputes look-up tables and the logarithm of the wave-function from scratch
+  //this avoids the accumulation of round-off errors in the incremental updates
+  void Resync(){
+    for(int i=0;i<nrep_;i++){
+      psi_.InitLookup(v_[i],lt_[i]);
+      logval_[i]=psi_.LogVal(v_[i],lt_[i]);
+    }
+    nsweeps_=0;
   }
 
   VectorXd Visible(){
@@ -243,6 +268,11 @@ public:
 
   void SetVisible(const VectorXd & v){
     v_[0]=v;
+    Resync();
+  }
+
+  typename WfType::StateType LogVal(){
+    return logval_[0];
   }
 
 
@@ -262,6 +292,27 @@ public:
     return acc;
   }
 
+  //the look-up tables and the values of the wave-function are recomputed when the state is loaded
+  void SaveState(BinaryWriter & out)const{
+    out.Write(rgen_);
+    out.Write(v_);
+    out.Write(accept_);
+    out.Write(moves_);
+  }
+
+  void LoadState(BinaryReader & in){
+    in.Read(rgen_);
+    in.Read(v_);
+    in.Read(accept_);
+    in.Read(moves_);
+
+    if(v_.size()!=std::size_t(nrep_)){
+      cerr<<"# The saved state has "<<v_.size()<<" replicas, instead of "<<nrep_<<endl;
+      std::abort();
+    }
+    Resync();
+  }
+
   inline double realpart(const std::complex<double> & val)const{
     return val.real();
   }
@@ -52,6 +52,13 @@ template<class WfType,class H> class MetropolisHamiltonian: public AbstractSampl
   //Look-up tables
   typename WfType::LookupType lt_;
 
+  //current value of the logarithm of the wave-function
+  typename WfType::StateType logval_;
+
+  //number of sweeps after which logval_ is recomputed from scratch
+  int resync_every_;
+  int nsweeps_;
+
 
   vector<vector<int>> tochange_;
   vector<vector<double>> newconfs_;
@@ -93,6 +100,8 @@ public:
     accept_.resize(1);
     moves_.resize(1);
 
+    resync_every_=100;
+
     Seed();
 
     Reset(true);
@@ -124,7 +133,7 @@ public:
       hilbert_.RandomVals(v_,rgen_);
     }
 
-    psi_.InitLookup(v_,lt_);
+    Resync();
 
     accept_=VectorXd::Zero(1);
     moves_=VectorXd::Zero(1);
@@ -168,6 +177,7 @@ public:
         accept_[0]+=1;
         psi_.UpdateLookup(v_,tochange_[si],newconfs_[si],lt_);
         v_=v1_;
+        logval_+=lvd;
 
         #ifndef NDEBUG
         const auto psival2=psi_.LogVal(v_);
@@ -180,15 +190,33 @@ public:
       }
       moves_[0]+=1;
     }
+
+    nsweeps_++;
+    if(nsweeps_>=resync_every_){
+      Resync();
+    }
   }
 
 
+  //Recomputes look-up tables and the logarithm of the wave-function from scratch
+  //this avoids the accumulation of round-off errors in the incremental updates
+  void Resync(){
+    psi_.InitLookup(v_,lt_);
+    logval_=psi_.LogVal(v_,lt_);
+    nsweeps_=0;
+  }
+
   VectorXd Visible(){
     return v_;
   }
 
   void SetVisible(const VectorXd & v){
     v_=v;
+    Resync();
+  }
+
+  typename WfType::StateType LogVal(){
+    return logval_;
   }
 
 
@@ -208,6 +236,22 @@ public:
     return acc;
   }
 
+  //the look-up tables and the value of the wave-function are recomputed when the state is loaded
+  void SaveState(BinaryWriter & out)const{
+    out.Write(rgen_);
+    out.Write(v_);
+    out.Write(accept_);
+    out.Write(moves_);
+  }
+
+  void LoadState(BinaryReader & in){
+    in.Read(rgen_);
+    in.Read(v_);
+    in.Read(accept_);
+    in.Read(moves_);
+    Resync();
+  }
+
 };
 
 
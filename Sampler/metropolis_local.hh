@@ -50,6 +50,13 @@ template<class WfType> class MetropolisLocal: public AbstractSampler<WfType>{
   //Look-up tables
   typename WfType::LookupType lt_;
 
+  //current value of the logarithm of the wave-function
+  typename WfType::StateType logval_;
+
+  //number of sweeps after which logval_ is recomputed from scratch
+  int resync_every_;
+  int nsweeps_;
+
 
   int nstates_;
   vector<double> localstates_;
@@ -87,6 +94,8 @@ public:
     nstates_=hilbert_.LocalSize();
     localstates_=hilbert_.LocalStates();
 
+    resync_every_=100;
+
     Seed();
 
     Reset(true);
@@ -118,7 +127,7 @@ public:
       hilbert_.RandomVals(v_,rgen_);
     }
 
-    psi_.InitLookup(v_,lt_);
+    Resync();
 
     accept_=VectorXd::Zero(1);
     moves_=VectorXd::Zero(1);
@@ -166,6 +175,7 @@ public:
         accept_[0]+=1;
         psi_.UpdateLookup(v_,tochange,newconf,lt_);
         hilbert_.UpdateConf(v_,tochange,newconf);
+        logval_+=lvd;
 
         #ifndef NDEBUG
         const auto psival2=psi_.LogVal(v_);
@@ -178,15 +188,33 @@ public:
       }
       moves_[0]+=1;
     }
+
+    nsweeps_++;
+    if(nsweeps_>=resync_every_){
+      Resync();
+    }
   }
 
 
+  //Recomputes look-up tables and the logarithm of the wave-function from scratch
+  //this avoids the accumulation of round-off errors in the incremental updates
+  void Resync(){
+    psi_.InitLookup(v_,lt_);
+    logval_=psi_.LogVal(v_,lt_);
+    nsweeps_=0;
+  }
+
   VectorXd Visible(){
     return v_;
   }
 
   void SetVisible(const VectorXd & v){
     v_=v;
+    Resync();
+  }
+
+  typename WfType::StateType LogVal(){
+    return logval_;
   }
 
 
@@ -206,6 +234,22 @@ public:
     return acc;
   }
 
+  //the look-up tables and the value of the wave-function are recomputed when the state is loaded
+  void SaveState(BinaryWriter & out)const{
+    out.Write(rgen_);
+    out.Write(v_);
+    out.Write(accept_);
+    out.Write(moves_);
+  }
+
+  void LoadState(BinaryReader & in){
+    in.Read(rgen_);
+    in.Read(v_);
+    in.Read(accept_);
+    in.Read(moves_);
+    Resync();
+  }
+
 };
 
 
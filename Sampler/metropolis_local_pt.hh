@@ -54,6 +54,13 @@ template<class WfType> class MetropolisLocalPt: public AbstractSampler<WfType>{
   //Look-up tables
   std::vector<typename WfType::LookupType> lt_;
 
+  //current values of the logarithm of the wave-function, for each replica
+  std::vector<typename WfType::StateType> logval_;
+
+  //number of sweeps after which logval_ is recomputed from scratch
+  int resync_every_;
+  int nsweeps_;
+
   int nrep_;
 
   vector<double> beta_;
@@ -89,6 +96,8 @@ public:
     nstates_=hilbert_.LocalSize();
     localstates_=hilbert_.LocalStates();
 
+    resync_every_=100;
+
     SetNreplicas(nrep_);
 
     if(mynode_==0){
@@ -109,6 +118,7 @@ public:
     }
 
     lt_.resize(nrep_);
+    logval_.resize(nrep_);
 
     accept_.resize(2*nrep_);
     moves_.resize(2*nrep_);
@@ -143,9 +153,7 @@ public:
       }
     }
 
-    for(int i=0;i<nrep_;i++){
-      psi_.InitLookup(v_[i],lt_[i]);
-    }
+    Resync();
 
     accept_=VectorXd::Zero(2*nrep_);
     moves_=VectorXd::Zero(2*nrep_);
@@ -194,6 +202,7 @@ public:
 
         psi_.UpdateLookup(v_[rep],tochange,newconf,lt_[rep]);
         hilbert_.UpdateConf(v_[rep],tochange,newconf);
+        logval_[rep]+=lvd;
 
         #ifndef NDEBUG
         const auto psival2=psi_.LogVal(v_[rep]);
@@ -238,12 +247,16 @@ public:
       moves_(nrep_+r-1)+=1;
     }
 
+    nsweeps_++;
+    if(nsweeps_>=resync_every_){
+      Resync();
+    }
   }
 
   //computes the probability to exchange two replicas
   double ExchangeProb(int r1,int r2){
-    const double lf1=2*std::real(psi_.LogVal(v_[r1],lt_[r1]));
-    const double lf2=2*std::real(psi_.LogVal(v_[r2],lt_[r2]));
+    const double lf1=2*std::real(logval_[r1]);
+    const double lf2=2*std::real(logval_[r2]);
 
     return std::exp((beta_[r1]-beta_[r2])*(lf2-lf1));
   }
@@ -251,6 +264,17 @@ public:
   void Exchange(int r1,int r2){
     std::swap(v_[r1],v_[r2]);
     std::swap(lt_[r1],lt_[r2]);
+    std::swap(logval_[r1],logval_[r2]);
+  }
+
+  //Recomputes look-up tables and the logarithm of the wave-function from scratch
+  //this avoids the accumulation of round-off errors in the incremental updates
+  void Resync(){
+    for(int i=0;i<nrep_;i++){
+      psi_.InitLookup(v_[i],lt_[i]);
+      logval_[i]=psi_.LogVal(v_[i],lt_[i]);
+    }
+    nsweeps_=0;
   }
 
   VectorXd Visible(){
@@ -259,6 +283,11 @@ public:
 
   void SetVisible(const VectorXd & v){
     v_[0]=v;
+    Resync();
+  }
+
+  typename WfType::StateType LogVal(){
+    return logval_[0];
   }
 
 
@@ -274,6 +303,27 @@ public:
     return acc;
   }
 
+  //the look-up tables and the values of the wave-function are recomputed when the state is loaded
+  void SaveState(BinaryWriter & out)const{
+    out.Write(rgen_);
+    out.Write(v_);
+    out.Write(accept_);
+    out.Write(moves_);
+  }
+
+  void LoadState(BinaryReader & in){
+    in.Read(rgen_);
+    in.Read(v_);
+    in.Read(accept_);
+    in.Read(moves_);
+
+    if(v_.size()!=std::size_t(nrep_)){
+      cerr<<"# The saved state has "<<v_.size()<<" replicas, instead of "<<nrep_<<endl;
+      std::abort();
+    }
+    Resync();
+  }
+
 
 };
 
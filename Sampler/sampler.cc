@@ -53,6 +53,9 @@ public:
     else if(pars["Sampler"]["Name"]=="MetropolisHamiltonianPt"){
       s_=new MetropolisHamiltonianPt<WfType,Hamiltonian<Graph>>(graph,psi,hamiltonian,pars);
     }
+    else if(pars["Sampler"]["Name"]=="HeatBathLocal"){
+      s_=new HeatBathLocal<WfType>(graph,psi,pars);
+    }
     else{
       cout<<"Sampler not found"<<endl;
       std::abort();
@@ -71,12 +74,21 @@ public:
   void SetVisible(const VectorXd & v){
     return s_->SetVisible(v);
   }
+  typename WfType::StateType LogVal(){
+    return s_->LogVal();
+  }
   WfType & Psi(){
     return s_->Psi();
   }
   VectorXd Acceptance()const{
     return s_->Acceptance();
   }
+  void SaveState(BinaryWriter & out)const{
+    return s_->SaveState(out);
+  }
+  void LoadState(BinaryReader & in){
+    return s_->LoadState(in);
+  }
 
 };
 }
@@ -25,6 +25,7 @@ namespace netket{
   template<class WfType> class MetropolisHop;
   template<class WfType,class HamType> class MetropolisHamiltonian;
   template<class WfType,class HamType> class MetropolisHamiltonianPt;
+  template<class WfType> class HeatBathLocal;
   template<class WfType> class Sampler;
 }
 
@@ -36,5 +37,6 @@ namespace netket{
 #include "metropolis_hop.hh"
 #include "metropolis_hamiltonian.hh"
 #include "metropolis_hamiltonian_pt.hh"
+#include "heat_bath_local.hh"
 #include "sampler.cc"
 #endif
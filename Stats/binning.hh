@@ -211,11 +211,12 @@ public:
     j["Mean"]=mean;
     j["Sigma"]=eomean;
     j["Taucorr"]=tcorr;
+    j["Neff"]=EffectiveSizeOp(N(),tcorr);
 
     return j;
   }
 
-  int NvalProc(){
+  int NvalProc()const{
     int nv=0;
 
     for(int i=0;i<last1_;i++){
@@ -227,7 +228,7 @@ public:
     return nv;
   }
 
-  int N(){
+  int N()const{
     int Np=NvalProc();
     SumOnNodes(Np);
     return Np;
@@ -259,6 +260,20 @@ public:
     return 0.5*(std::pow(erbinned/erunbinned,2.)-1.);
   }
 
+  //Effective number of independent samples, given the auto-correlation time
+  double EffectiveSizeOp(int n,double tau)const{
+    return double(n)/(1.+2.*std::max(tau,0.));
+  }
+
+  VectorXd EffectiveSizeOp(int n,const VectorXd & tau)const{
+    VectorXd result(tau.size());
+
+    for(int i=0;i<result.size();i++){
+      result(i)=EffectiveSizeOp(n,tau(i));
+    }
+    return result;
+  }
+
   double EoMeanOp(double sigma2)const{
     return std::sqrt(sigma2)/(double(nproc_));
   }
@@ -20,7 +20,18 @@ using namespace std;
 using namespace netket;
 
 int main(int argc,char * argv[]){
-  MPI_Init(&argc,&argv);
+  //the output is written by a separate thread, which does not use MPI
+  int provided;
+  MPI_Init_thread(&argc,&argv,MPI_THREAD_FUNNELED,&provided);
+
+  if(provided<MPI_THREAD_FUNNELED){
+    int mynode;
+    MPI_Comm_rank(MPI_COMM_WORLD,&mynode);
+    if(mynode==0){
+      cerr<<"# The MPI library does not support MPI_THREAD_FUNNELED, which is needed by the output and worker threads"<<endl;
+    }
+    std::abort();
+  }
 
   if(argc!=2){
     cerr<<"Insert name of input Json file"<<endl;
@@ -42,13 +53,34 @@ int main(int argc,char * argv[]){
 
   Hamiltonian<Graph> hamiltonian(graph,pars);
 
+  //the wave-function can be either optimized, or only used to estimate the observables.
+  //The ground state can also be found by exact diagonalization, without a wave-function
+  std::string mode=FieldOrDefaultVal(pars,"Mode",std::string("Learning"));
+
+  if(mode=="ExactDiag"){
+    ExactDiag<Hamiltonian<Graph>> ed(hamiltonian,pars);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Finalize();
+    return 0;
+  }
+
   using Psi=Machine<complex<double>>;
   Psi machine(graph,hamiltonian,pars);
 
   Sampler<Psi> sampler(graph,hamiltonian,machine,pars);
 
-  Stepper stepper(pars);
-  Learning<Hamiltonian<Graph>,Psi,Sampler<Psi>,Stepper> learning(hamiltonian,sampler,stepper,pars);
+  if(mode=="Learning"){
+    Stepper stepper(pars);
+    Learning<Hamiltonian<Graph>,Psi,Sampler<Psi>,Stepper> learning(hamiltonian,sampler,stepper,pars);
+  }
+  else if(mode=="Estimate"){
+    Estimator<Hamiltonian<Graph>,Psi,Sampler<Psi>> estimator(hamiltonian,sampler,pars);
+  }
+  else{
+    cerr<<"Unknown Mode "<<mode<<endl;
+    std::abort();
+  }
 
   MPI_Barrier(MPI_COMM_WORLD);
   MPI_Finalize();
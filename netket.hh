@@ -25,6 +25,7 @@ namespace netket{
 #include "External/Json/json.hpp"
 #include "Json/json.hh"
 #include "Parallel/parallel.hh"
+#include "Checkpoint/checkpoint.hh"
 #include "Lookup/lookup.hh"
 #include "Stats/stats.hh"
 #include "Hilbert/hilbert.hh"
@@ -34,5 +35,6 @@ namespace netket{
 #include "Machines/machines.hh"
 #include "Sampler/sampler.hh"
 #include "Learning/learning.hh"
+#include "ExactDiag/exact_diag.hh"
 
 #endif